@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file spectrograph_benchmark.c
+ *  @brief Measures the spectrograph under each cache policy.
+ *
+ *  Two workloads are measured. The hot workload transforms the same frame
+ *  over and over into the same output, which is what a latency sensitive
+ *  caller does. The streaming workload transforms a signal which is much
+ *  larger than the last level cache into a spectrogram which is just as
+ *  large, which is what a bulk job does.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Spectrograph Run-time */
+#include "../src/spectrograph.h"
+
+/* The number of frames transformed by the hot workload. */
+#define HOT_FRAMES 100000
+
+/* The number of runs of each workload; the fastest one is reported so the
+   numbers are not skewed by the rest of the system. */
+#define RUNS 5
+
+/* The number of frames transformed by the streaming workload (64MB). */
+#define STREAM_FRAMES 131072
+
+/* The output stride, with the fragments packed back to back. */
+#define OUTPUT_STRIDE 65
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double bench_hot(spectrograph_t *sg, float *input, float *output) {
+  double start = now();
+  for (unsigned int idx = 0; idx < HOT_FRAMES; idx++) {
+    spectrograph_transform(sg, input, output);
+  }
+  return (now() - start) / HOT_FRAMES;
+}
+
+static double bench_stream(spectrograph_t *sg, float *input, float *output) {
+  double start = now();
+  for (unsigned int idx = 0; idx < STREAM_FRAMES; idx++) {
+    spectrograph_transform(sg, &input[idx * 128],
+      &output[idx * OUTPUT_STRIDE]);
+  }
+  return (now() - start) / STREAM_FRAMES;
+}
+
+int main(void) {
+  float *input = (float*)aligned_alloc(32,
+    sizeof(float) * 128 * STREAM_FRAMES);
+  float *output = (float*)aligned_alloc(32,
+    sizeof(float) * OUTPUT_STRIDE * STREAM_FRAMES);
+  spectrograph_t *sg = spectrograph_create();
+  if (input == NULL || output == NULL || sg == NULL) {
+    fprintf(stderr, "Unable to allocate the benchmark buffers.\n");
+    return EXIT_FAILURE;
+  }
+  for (unsigned int idx = 0; idx < 128 * STREAM_FRAMES; idx++) {
+    input[idx] = (float)(16384 * sin((2 * M_PI * idx * 1000) / 8000));
+  }
+  const char *names[] = { "latency", "throughput" };
+  spectrograph_cache_policy_t policies[] = {
+    SPECTROGRAPH_CACHE_LATENCY,
+    SPECTROGRAPH_CACHE_THROUGHPUT
+  };
+  for (unsigned int idx = 0; idx < 2; idx++) {
+    spectrograph_set_cache_policy(sg, policies[idx]);
+    /* Warm up the page tables and the caches. */
+    bench_stream(sg, input, output);
+    double hot = INFINITY, stream = INFINITY;
+    for (unsigned int run = 0; run < RUNS; run++) {
+      hot = fmin(hot, bench_hot(sg, input, output));
+      stream = fmin(stream, bench_stream(sg, input, output));
+    }
+    printf("%-10s hot:    %8.1f ns/frame\n", names[idx], hot);
+    printf("%-10s stream: %8.1f ns/frame\n", names[idx], stream);
+  }
+  spectrograph_destroy(sg);
+  free(output);
+  free(input);
+  return EXIT_SUCCESS;
+}
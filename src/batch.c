@@ -0,0 +1,358 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file batch.c
+ *  @brief Implements the batch interface.
+ *
+ *  The work queue lives in an anonymous shared mapping created before the
+ *  workers are forked. A file is claimed by swapping its owner from zero to
+ *  the pid of the worker, so the calling process can tell which file a dead
+ *  worker was holding and hand it out again. The files are handed out in
+ *  order through a shared cursor; once it runs past the end, workers look
+ *  for the files which were handed out again.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Intel Integrated Performance Primitives */
+#include "ipp.h"
+
+/* Spectrograph Run-time */
+#include "batch.h"
+#include "plan.h"
+#include "spectrograph.h"
+
+/* The suffix which mkstemp replaces in the path of a temporary output. */
+#define BATCH_TEMP_SUFFIX ".XXXXXX"
+
+typedef struct batch_entry {
+  /* The pid of the worker which claimed the file, or zero. */
+  int32_t  owner;
+  uint32_t status;
+  uint32_t attempts;
+  /* The suffix of the temporary output of the file, or empty. */
+  char     suffix[sizeof(BATCH_TEMP_SUFFIX)];
+} batch_entry_t;
+
+typedef struct batch_queue {
+  unsigned int  n_files;
+  unsigned int  cursor;
+  batch_entry_t entries[];
+} batch_queue_t;
+
+static bool batch_try_claim(batch_entry_t *entry, int32_t pid) {
+  int32_t none = 0;
+  return __atomic_compare_exchange_n(&entry->owner, &none, pid, false,
+    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Claim the next file of the queue.
+ *
+ * @return The index of the file or -1 if there is nothing left to claim.
+ */
+static int batch_claim(batch_queue_t *queue, int32_t pid) {
+  for (;;) {
+    unsigned int idx = __atomic_fetch_add(&queue->cursor, 1,
+      __ATOMIC_RELAXED);
+    if (idx >= queue->n_files) {
+      break;
+    }
+    if (batch_try_claim(&queue->entries[idx], pid)) {
+      return idx;
+    }
+  }
+  /* Look for the files which were handed out again. */
+  for (unsigned int idx = 0; idx < queue->n_files; idx++) {
+    if (batch_try_claim(&queue->entries[idx], pid)) {
+      return idx;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Build the path of the temporary output of a file into a new string.
+ */
+static char* batch_temp_path(const char *output_path, const char *suffix) {
+  size_t len = strlen(output_path);
+  char *path = (char*)malloc(len + sizeof(BATCH_TEMP_SUFFIX));
+  if (path != NULL) {
+    memcpy(path, output_path, len);
+    memcpy(&path[len], suffix, sizeof(BATCH_TEMP_SUFFIX));
+  }
+  return path;
+}
+
+/**
+ * Generate the spectrogram of one file into the mapping of a temporary
+ * output, which replaces the output once it is complete.
+ */
+static bool batch_process(spectrograph_t *sg, float *frame,
+                          batch_entry_t *entry, const char *input_path,
+                          const char *output_path, unsigned int hop) {
+  unsigned int n_samples = spectrograph_n_samples(sg);
+  unsigned int n_bins = spectrograph_output_len(n_samples);
+  int input = open(input_path, O_RDONLY);
+  if (input < 0) {
+    unlink(output_path);
+    return false;
+  }
+  struct stat st;
+  char *temp_path = NULL;
+  int output = -1;
+  bool success = fstat(input, &st) == 0 && S_ISREG(st.st_mode) &&
+    (temp_path = batch_temp_path(output_path, BATCH_TEMP_SUFFIX)) != NULL &&
+    (output = mkstemp(temp_path)) >= 0;
+  if (output >= 0) {
+    /* Let the calling process remove the temporary output if the worker
+       dies. */
+    memcpy(entry->suffix, &temp_path[strlen(output_path)],
+      sizeof(entry->suffix));
+  }
+  size_t n_input = success ? st.st_size / sizeof(Ipp16s) : 0;
+  size_t n_frames =
+    n_input >= n_samples ? (n_input - n_samples) / hop + 1 : 0;
+  size_t output_size = sizeof(float) * n_bins * n_frames;
+  /* Size the output up front so the fragments can be written in place. */
+  success = success && fchmod(output, 0644) == 0 &&
+    ftruncate(output, output_size) == 0;
+  if (success && n_frames > 0) {
+    Ipp16s *samples = (Ipp16s*)mmap(NULL, st.st_size, PROT_READ,
+      MAP_PRIVATE, input, 0);
+    float *fragments = (float*)mmap(NULL, output_size,
+      PROT_READ | PROT_WRITE, MAP_SHARED, output, 0);
+    success = samples != MAP_FAILED && fragments != MAP_FAILED;
+    if (success) {
+      madvise(samples, st.st_size, MADV_SEQUENTIAL);
+      for (size_t idx = 0; idx < n_frames && success; idx++) {
+        success = ippsConvert_16s32f(&samples[idx * hop], frame,
+          n_samples) == ippStsNoErr && spectrograph_transform(sg, frame,
+          &fragments[idx * n_bins]);
+      }
+    }
+    if (samples != MAP_FAILED) {
+      munmap(samples, st.st_size);
+    }
+    if (fragments != MAP_FAILED) {
+      munmap(fragments, output_size);
+    }
+  }
+  if (output >= 0) {
+    close(output);
+  }
+  close(input);
+  success = success && rename(temp_path, output_path) == 0;
+  /* Never leave an output which looks like a spectrogram behind. */
+  if (!success) {
+    if (output >= 0) {
+      unlink(temp_path);
+    }
+    unlink(output_path);
+  }
+  entry->suffix[0] = '\0';
+  free(temp_path);
+  return success;
+}
+
+/**
+ * Process files from the queue until it is empty. Never returns.
+ */
+static void batch_worker(batch_queue_t *queue, const char **input_paths,
+                         const char **output_paths, unsigned int n_samples,
+                         unsigned int hop, unsigned int timeout) {
+  int32_t pid = getpid();
+  /* Make sure the deadline kills the worker. */
+  signal(SIGALRM, SIG_DFL);
+  spectrograph_t *sg = spectrograph_create_size(n_samples);
+  float *frame = (float*)aligned_alloc(32, sizeof(float) * n_samples);
+  if (sg == NULL || frame == NULL) {
+    _exit(EXIT_FAILURE);
+  }
+  int idx;
+  while ((idx = batch_claim(queue, pid)) >= 0) {
+    /* A worker stuck on a file is killed by SIGALRM and handled like any
+       other dead worker. */
+    alarm(timeout);
+    uint32_t status = batch_process(sg, frame, &queue->entries[idx],
+      input_paths[idx], output_paths[idx], hop) ? BATCH_DONE : BATCH_FAILED;
+    alarm(0);
+    __atomic_store_n(&queue->entries[idx].status, status, __ATOMIC_RELEASE);
+  }
+  free(frame);
+  spectrograph_destroy(sg);
+  _exit(EXIT_SUCCESS);
+}
+
+/**
+ * Hand out again the file a dead worker was holding, or give up on it once
+ * it has been attempted BATCH_MAX_ATTEMPTS times. Either way, remove what
+ * the worker left of the output.
+ */
+static void batch_recover(batch_queue_t *queue, const char **output_paths,
+                          pid_t pid) {
+  for (unsigned int idx = 0; idx < queue->n_files; idx++) {
+    batch_entry_t *entry = &queue->entries[idx];
+    if (__atomic_load_n(&entry->owner, __ATOMIC_ACQUIRE) != pid ||
+        __atomic_load_n(&entry->status, __ATOMIC_ACQUIRE) != BATCH_PENDING) {
+      continue;
+    }
+    if (entry->suffix[0] != '\0') {
+      char *temp_path = batch_temp_path(output_paths[idx], entry->suffix);
+      if (temp_path != NULL) {
+        unlink(temp_path);
+        free(temp_path);
+      }
+      entry->suffix[0] = '\0';
+    }
+    if (++entry->attempts >= BATCH_MAX_ATTEMPTS) {
+      unlink(output_paths[idx]);
+      __atomic_store_n(&entry->status, BATCH_FAILED, __ATOMIC_RELEASE);
+    } else {
+      __atomic_store_n(&entry->owner, 0, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+/**
+ * Check whether any file is waiting to be claimed.
+ */
+static bool batch_unclaimed(batch_queue_t *queue) {
+  for (unsigned int idx = 0; idx < queue->n_files; idx++) {
+    if (__atomic_load_n(&queue->entries[idx].owner, __ATOMIC_ACQUIRE) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int batch_run(const char **input_paths, const char **output_paths,
+              unsigned int n_files, unsigned int n_workers,
+              unsigned int n_samples, unsigned int hop,
+              unsigned int timeout, batch_status_t *status) {
+  if (n_workers == 0 || n_workers > BATCH_MAX_WORKERS || hop == 0) {
+    return -1;
+  }
+  /* Acquire the plan before forking so the workers share its tables. */
+  plan_t *plan = plan_acquire(n_samples, PLAN_WINDOW_HANN);
+  if (plan == NULL) {
+    return -1;
+  }
+  size_t queue_size =
+    sizeof(batch_queue_t) + sizeof(batch_entry_t) * n_files;
+  batch_queue_t *queue = (batch_queue_t*)mmap(NULL, queue_size,
+    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (queue == MAP_FAILED) {
+    plan_release(plan);
+    return -1;
+  }
+  memset(queue, 0, queue_size);
+  queue->n_files = n_files;
+  pid_t workers[BATCH_MAX_WORKERS];
+  unsigned int n_running = 0;
+  for (unsigned int idx = 0; idx < n_workers; idx++) {
+    workers[idx] = -1;
+  }
+  for (unsigned int idx = 0; idx < n_workers && idx < n_files; idx++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      batch_worker(queue, input_paths, output_paths, n_samples, hop,
+        timeout);
+    }
+    workers[idx] = pid;
+    if (pid > 0) {
+      n_running++;
+    }
+  }
+  if (n_running == 0 && n_files > 0) {
+    munmap(queue, queue_size);
+    plan_release(plan);
+    return -1;
+  }
+  /* Bound the number of replacement workers so a worker which cannot start
+     does not get replaced forever. */
+  unsigned int n_restarts = n_files * BATCH_MAX_ATTEMPTS;
+  while (n_running > 0) {
+    int wstatus;
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    unsigned int slot = 0;
+    while (slot < n_workers && workers[slot] != pid) {
+      slot++;
+    }
+    if (slot == n_workers) {
+      continue;
+    }
+    workers[slot] = -1;
+    n_running--;
+    if (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS) {
+      continue;
+    }
+    /* Hand out the file of the dead worker and replace the worker. */
+    batch_recover(queue, output_paths, pid);
+    if (n_restarts > 0 && batch_unclaimed(queue)) {
+      n_restarts--;
+      pid = fork();
+      if (pid == 0) {
+        batch_worker(queue, input_paths, output_paths, n_samples, hop,
+          timeout);
+      }
+      workers[slot] = pid;
+      if (pid > 0) {
+        n_running++;
+      }
+    }
+  }
+  int n_done = 0;
+  for (unsigned int idx = 0; idx < n_files; idx++) {
+    batch_status_t file_status = (batch_status_t)queue->entries[idx].status;
+    if (file_status == BATCH_DONE) {
+      n_done++;
+    }
+    if (status != NULL) {
+      status[idx] = file_status;
+    }
+  }
+  munmap(queue, queue_size);
+  plan_release(plan);
+  return n_done;
+}
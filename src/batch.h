@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file batch.h
+ *  @brief Public functions, macros and type definitions used for
+ *         generating the spectrograms of many files at once.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/**
+ * The largest number of worker processes of a batch.
+ */
+#define BATCH_MAX_WORKERS 256
+
+/**
+ * The number of times a file is attempted before it is given up on when the
+ * worker processing it dies.
+ */
+#define BATCH_MAX_ATTEMPTS 2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The status of a file of a batch.
+ *
+ * BATCH_PENDING files were not processed.
+ *
+ * BATCH_DONE files have had their spectrogram written.
+ *
+ * BATCH_FAILED files could not be read or written, or every worker which
+ * processed them died.
+ */
+typedef enum batch_status {
+  BATCH_PENDING,
+  BATCH_DONE,
+  BATCH_FAILED
+} batch_status_t;
+
+/**
+ * Generate the spectrograms of a batch of files with several worker
+ * processes.
+ *
+ * Each input file holds raw 16 bit signed samples in the byte order of the
+ * host. Its spectrogram is written to the matching output file as the
+ * fragments of every complete frame back to back, each of
+ * spectrograph_output_len(n_samples) floats. The fragments are written
+ * straight into the mapping of a temporary file next to the output file,
+ * which replaces the output file once the spectrogram is complete. The
+ * output file of a file which failed is removed, so it never holds a
+ * partial spectrogram.
+ *
+ * The workers are forked from the calling process and each one has its own
+ * spectrograph. They take the files from a work queue in memory shared with
+ * the calling process, which waits for them. When a worker dies, the file
+ * it was processing is handed out again, up to BATCH_MAX_ATTEMPTS times,
+ * and a new worker takes its place, so a bad file does not stop the rest
+ * of the batch. A worker which spends longer than the timeout on one file
+ * is killed and handled the same way.
+ *
+ * The calling process reaps its children while it waits, so it should not
+ * have other children which exit during the batch, nor other threads using
+ * spectrographs when it forks.
+ *
+ * @param input_paths The paths of the input files.
+ *
+ * @param output_paths The paths of the output files.
+ *
+ * @param n_files The number of files.
+ *
+ * @param n_workers The number of worker processes, between 1 and
+ *                  BATCH_MAX_WORKERS.
+ *
+ * @param n_samples The number of samples per frame. Must be a power of two
+ *                  between PLAN_MIN_SAMPLES and PLAN_MAX_SAMPLES.
+ *
+ * @param hop The number of samples between the frames, at least 1.
+ *
+ * @param timeout The longest a worker may spend on one file, in seconds, or
+ *                zero for no limit.
+ *
+ * @param status A pointer to an array of length n_files which will store
+ *               the status of each file, or NULL.
+ *
+ * @return The number of files whose spectrogram was written or -1 if the
+ *         batch could not be started.
+ */
+int batch_run(const char **input_paths, const char **output_paths,
+              unsigned int n_files, unsigned int n_workers,
+              unsigned int n_samples, unsigned int hop,
+              unsigned int timeout, batch_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_H */
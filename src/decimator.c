@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file decimator.c
+ *  @brief Implements the decimator interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Spectrograph Run-time */
+#include "decimator.h"
+#include "dsp.h"
+#include "vector.h"
+
+/* The number of input samples buffered per block. */
+#define DECIMATOR_BLOCK_LEN 1024
+
+/* The cut-off of the anti-aliasing filter, relative to the new Nyquist
+   frequency. */
+#define DECIMATOR_CUTOFF 0.9
+
+typedef struct decimator {
+  float        *buffers;
+  unsigned int  factor;
+  /* Constants */
+  float        *taps;
+  unsigned int  taps_len;
+  /* History */
+  float        *history;
+  unsigned int  history_len;
+  unsigned int  history_pos;
+} decimator_t;
+
+decimator_t* decimator_create(unsigned int factor) {
+  if (factor < DECIMATOR_MIN_FACTOR || factor > DECIMATOR_MAX_FACTOR) {
+    return NULL;
+  }
+  decimator_t *dec = (decimator_t*)malloc(sizeof(decimator_t));
+  if (dec == NULL) {
+    return NULL;
+  }
+  unsigned int taps_len = decimator_taps_len(factor);
+  unsigned int buffers_size =
+    sizeof(float) * (taps_len * 2 + DECIMATOR_BLOCK_LEN);
+  float *buffers = (float*)aligned_alloc(32, buffers_size);
+  if (buffers == NULL) {
+    free(dec);
+    return NULL;
+  }
+  dec->buffers = buffers;
+  dec->factor = factor;
+  dec->taps = buffers;
+  dec->taps_len = taps_len;
+  dec->history = &buffers[taps_len];
+  /* Compute a windowed sinc low pass filter with unity gain at DC. The
+     cut-off sits below the new Nyquist frequency so the transition band of
+     the window is attenuated before it folds back into the output. */
+  double sum = 0;
+  for (unsigned int idx = 0; idx < taps_len; idx++) {
+    double x = (idx - (taps_len - 1) / 2.0) * DECIMATOR_CUTOFF / factor;
+    dec->taps[idx] = sinc_func(x) * blackman_func(idx, taps_len);
+    sum += dec->taps[idx];
+  }
+  for (unsigned int idx = 0; idx < taps_len; idx++) {
+    dec->taps[idx] /= sum;
+  }
+  /* Prime the history so the first output is aligned on the first input. */
+  memset(dec->history, 0, sizeof(float) * (taps_len - 1));
+  dec->history_len = taps_len - 1;
+  dec->history_pos = 0;
+  return dec;
+}
+
+void decimator_destroy(decimator_t *dec) {
+  free(dec->buffers);
+  free(dec);
+}
+
+unsigned int decimator_factor(decimator_t *dec) {
+  return dec->factor;
+}
+
+unsigned int decimator_process(decimator_t *dec, float *input,
+                               unsigned int n_input, unsigned int *n_consumed,
+                               float *output, unsigned int n_output) {
+  unsigned int capacity = dec->taps_len + DECIMATOR_BLOCK_LEN;
+  unsigned int consumed = 0;
+  unsigned int produced = 0;
+  for (;;) {
+    /* Only evaluate the filter at the samples which are kept. */
+    while (dec->history_pos + dec->taps_len <= dec->history_len &&
+           produced < n_output) {
+      output[produced++] = vec_dot(&dec->history[dec->history_pos],
+        dec->taps, dec->taps_len);
+      dec->history_pos += dec->factor;
+    }
+    if (produced == n_output || consumed == n_input) {
+      break;
+    }
+    /* Discard the samples which are no longer needed and refill. */
+    dec->history_len -= dec->history_pos;
+    memmove(dec->history, &dec->history[dec->history_pos],
+      sizeof(float) * dec->history_len);
+    dec->history_pos = 0;
+    unsigned int len = capacity - dec->history_len;
+    if (len > n_input - consumed) {
+      len = n_input - consumed;
+    }
+    memcpy(&dec->history[dec->history_len], &input[consumed],
+      sizeof(float) * len);
+    dec->history_len += len;
+    consumed += len;
+  }
+  *n_consumed = consumed;
+  return produced;
+}
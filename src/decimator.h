@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file decimator.h
+ *  @brief Public functions, macros and type definitions used for
+ *         decimating input signals.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+/**
+ * The smallest supported decimation factor.
+ */
+#define DECIMATOR_MIN_FACTOR 2
+
+/**
+ * The largest supported decimation factor.
+ */
+#define DECIMATOR_MAX_FACTOR 12
+
+/**
+ * Compute the number of taps of the anti-aliasing filter of a decimator.
+ *
+ * @param factor The decimation factor.
+ *
+ * @return The number of taps.
+ */
+#define decimator_taps_len(factor) (32 * (factor))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A decimator low pass filters an input signal and keeps one out of every
+ * factor samples.
+ *
+ * The filter is evaluated in polyphase form: only the output samples which
+ * are kept are ever computed, so the cost per input sample is the number of
+ * taps divided by the decimation factor.
+ */
+typedef struct decimator decimator_t;
+
+/**
+ * Create a new decimator.
+ *
+ * @param factor The decimation factor, between DECIMATOR_MIN_FACTOR and
+ *               DECIMATOR_MAX_FACTOR.
+ *
+ * @return A new decimator or NULL if the factor is not supported.
+ */
+decimator_t* decimator_create(unsigned int factor);
+
+/**
+ * Release the resources allocated by a decimator.
+ *
+ * @return Void.
+ */
+void         decimator_destroy(decimator_t *dec);
+
+/**
+ * Get the decimation factor of a decimator.
+ *
+ * @param dec A decimator.
+ *
+ * @return The decimation factor.
+ */
+unsigned int decimator_factor(decimator_t *dec);
+
+/**
+ * Decimate a block of the input signal.
+ *
+ * The decimator keeps the history needed by its filter between calls, so
+ * a signal may be decimated one block at a time. Decimation stops when
+ * either the input is exhausted or the output is full; the input which was
+ * not consumed should be passed to the next call.
+ *
+ * @param dec A decimator.
+ *
+ * @param input A pointer to an array of floats of length n_input.
+ *
+ * @param n_input The number of input samples.
+ *
+ * @param n_consumed The destination for the number of input samples which
+ *                   were consumed.
+ *
+ * @param output A pointer to an array of floats of length n_output.
+ *
+ * @param n_output The maximum number of output samples.
+ *
+ * @return The number of output samples.
+ */
+unsigned int decimator_process(decimator_t *dec, float *input,
+                               unsigned int n_input, unsigned int *n_consumed,
+                               float *output, unsigned int n_output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECIMATOR_H */
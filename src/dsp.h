@@ -38,4 +38,24 @@
  */
 #define hann_func(n, N) (0.5 * (1 - cos((2 * M_PI * (n)) / ((N) - 1))))
 
+/**
+ * Compute the Blackman function.
+ *
+ * @param n The index at time t.
+ * @param N The number of samples per frame.
+ *
+ * Return The result of the Blackman function.
+ */
+#define blackman_func(n, N) (0.42 - 0.5 * cos((2 * M_PI * (n)) / ((N) - 1)) + \
+                             0.08 * cos((4 * M_PI * (n)) / ((N) - 1)))
+
+/**
+ * Compute the normalized sinc function.
+ *
+ * @param x The argument.
+ *
+ * Return The result of the normalized sinc function.
+ */
+#define sinc_func(x) ((x) == 0 ? 1.0 : sin(M_PI * (x)) / (M_PI * (x)))
+
 #endif /* DSP_H */
\ No newline at end of file
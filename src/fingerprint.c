@@ -0,0 +1,527 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file fingerprint.c
+ *  @brief Implements the fingerprint interface.
+ *
+ *  A landmark hash packs the bin of the first peak (7 bits), the bin
+ *  distance to the second peak (6 bits) and the frame distance to the
+ *  second peak (6 bits).
+ *
+ *  The index file starts with a header followed by the sorted hashes and
+ *  the postings (track and offset) in the same order. The hashes are padded
+ *  to an even number so the postings stay aligned; the header holds the
+ *  number of landmarks without the padding.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Spectrograph Run-time */
+#include "fingerprint.h"
+#include "spectrograph.h"
+
+/* The number of bins per spectrogram fragment. */
+#define FINGERPRINT_BINS spectrograph_output_len(128)
+
+/* The largest number of peaks per frame: peaks are at least
+   FINGERPRINT_PEAK_BINS + 1 bins apart. */
+#define FINGERPRINT_MAX_PEAKS \
+  ((FINGERPRINT_BINS + FINGERPRINT_PEAK_BINS) / (FINGERPRINT_PEAK_BINS + 1))
+
+/* The magic number at the start of an index file. */
+#define FINGERPRINT_FILE_MAGIC "SPECFPIX"
+
+typedef struct fingerprint_peak {
+  uint32_t frame;
+  uint32_t bin;
+} fingerprint_peak_t;
+
+typedef struct fingerprint_posting {
+  uint32_t track;
+  uint32_t offset;
+} fingerprint_posting_t;
+
+typedef struct fingerprint_entry {
+  uint32_t hash;
+  uint32_t track;
+  uint32_t offset;
+} fingerprint_entry_t;
+
+typedef struct fingerprint_file_header {
+  char     magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t len;
+} fingerprint_file_header_t;
+
+typedef struct fingerprint_index {
+  /* Sorted */
+  uint32_t              *hashes;
+  fingerprint_posting_t *postings;
+  uint64_t               len;
+  /* Pending */
+  fingerprint_entry_t   *pending;
+  uint64_t               pending_len;
+  uint64_t               pending_cap;
+  /* Storage */
+  void                  *addr;
+  size_t                 addr_len;
+} fingerprint_index_t;
+
+/**
+ * Check whether a point of the spectrogram is a peak. Ties are broken in
+ * favour of the earliest point so a plateau yields a single peak.
+ */
+static bool fingerprint_is_peak(float *spectrogram, unsigned int n_frames,
+                                unsigned int frame, unsigned int bin) {
+  float value = spectrogram[frame * FINGERPRINT_BINS + bin];
+  if (value < FINGERPRINT_PEAK_FLOOR) {
+    return false;
+  }
+  unsigned int first_frame = frame > FINGERPRINT_PEAK_FRAMES ?
+    frame - FINGERPRINT_PEAK_FRAMES : 0;
+  unsigned int last_frame = frame + FINGERPRINT_PEAK_FRAMES < n_frames ?
+    frame + FINGERPRINT_PEAK_FRAMES : n_frames - 1;
+  unsigned int first_bin = bin > FINGERPRINT_PEAK_BINS ?
+    bin - FINGERPRINT_PEAK_BINS : 0;
+  unsigned int last_bin = bin + FINGERPRINT_PEAK_BINS < FINGERPRINT_BINS ?
+    bin + FINGERPRINT_PEAK_BINS : FINGERPRINT_BINS - 1;
+  for (unsigned int t = first_frame; t <= last_frame; t++) {
+    float *spectrum = &spectrogram[t * FINGERPRINT_BINS];
+    for (unsigned int f = first_bin; f <= last_bin; f++) {
+      bool earlier = t < frame || (t == frame && f < bin);
+      if (earlier ? spectrum[f] >= value : spectrum[f] > value) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+unsigned int fingerprint_extract(float *spectrogram, unsigned int n_frames,
+                                 fingerprint_landmark_t *landmarks,
+                                 unsigned int n_landmarks) {
+  if (n_frames == 0) {
+    return 0;
+  }
+  fingerprint_peak_t *peaks = (fingerprint_peak_t*)malloc(
+    sizeof(fingerprint_peak_t) * n_frames * FINGERPRINT_MAX_PEAKS);
+  if (peaks == NULL) {
+    return 0;
+  }
+  /* Pick the constellation of peaks, in time order. */
+  unsigned int n_peaks = 0;
+  for (unsigned int frame = 0; frame < n_frames; frame++) {
+    for (unsigned int bin = 0; bin < FINGERPRINT_BINS; bin++) {
+      if (fingerprint_is_peak(spectrogram, n_frames, frame, bin)) {
+        peaks[n_peaks].frame = frame;
+        peaks[n_peaks].bin = bin;
+        n_peaks++;
+      }
+    }
+  }
+  /* Pair each peak with the peaks which follow it. */
+  unsigned int n_found = 0;
+  for (unsigned int idx = 0; idx < n_peaks; idx++) {
+    unsigned int fan_out = 0;
+    for (unsigned int next = idx + 1;
+         next < n_peaks && fan_out < FINGERPRINT_FAN_OUT; next++) {
+      unsigned int dt = peaks[next].frame - peaks[idx].frame;
+      int df = (int)peaks[next].bin - (int)peaks[idx].bin;
+      if (dt > FINGERPRINT_MAX_DT) {
+        break;
+      }
+      if (dt == 0 || df < -FINGERPRINT_MAX_DF || df > FINGERPRINT_MAX_DF) {
+        continue;
+      }
+      if (n_found < n_landmarks) {
+        landmarks[n_found].hash = (peaks[idx].bin << 12) |
+          ((df + FINGERPRINT_MAX_DF) << 6) | dt;
+        landmarks[n_found].offset = peaks[idx].frame;
+      }
+      n_found++;
+      fan_out++;
+    }
+  }
+  free(peaks);
+  return n_found;
+}
+
+/**
+ * Extract the landmarks of a spectrogram into a new array.
+ */
+static fingerprint_landmark_t* fingerprint_extract_all(float *spectrogram,
+                                                       unsigned int n_frames,
+                                                       unsigned int *n) {
+  unsigned int cap = n_frames * FINGERPRINT_FAN_OUT * 2 + 1;
+  for (;;) {
+    fingerprint_landmark_t *landmarks = (fingerprint_landmark_t*)malloc(
+      sizeof(fingerprint_landmark_t) * cap);
+    if (landmarks == NULL) {
+      return NULL;
+    }
+    *n = fingerprint_extract(spectrogram, n_frames, landmarks, cap);
+    if (*n <= cap) {
+      return landmarks;
+    }
+    /* The spectrogram is denser than expected, try again. */
+    free(landmarks);
+    cap = *n;
+  }
+}
+
+fingerprint_index_t* fingerprint_index_create(void) {
+  return (fingerprint_index_t*)calloc(1, sizeof(fingerprint_index_t));
+}
+
+fingerprint_index_t* fingerprint_index_load(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(fingerprint_file_header_t)) {
+    close(fd);
+    return NULL;
+  }
+  size_t len = st.st_size;
+  void *addr = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return NULL;
+  }
+  fingerprint_file_header_t *header = (fingerprint_file_header_t*)addr;
+  size_t entry_size = sizeof(uint32_t) + sizeof(fingerprint_posting_t);
+  uint64_t padded_len = header->len + header->len % 2;
+  if (memcmp(header->magic, FINGERPRINT_FILE_MAGIC,
+             sizeof(header->magic)) != 0 ||
+      header->version != FINGERPRINT_FILE_VERSION ||
+      padded_len < header->len ||
+      padded_len > (len - sizeof(*header)) / entry_size) {
+    munmap(addr, len);
+    return NULL;
+  }
+  fingerprint_index_t *index = fingerprint_index_create();
+  if (index == NULL) {
+    munmap(addr, len);
+    return NULL;
+  }
+  index->addr = addr;
+  index->addr_len = len;
+  index->len = header->len;
+  index->hashes = (uint32_t*)&header[1];
+  index->postings = (fingerprint_posting_t*)&index->hashes[padded_len];
+  return index;
+}
+
+void fingerprint_index_destroy(fingerprint_index_t *index) {
+  if (index->addr != NULL) {
+    munmap(index->addr, index->addr_len);
+  } else {
+    free(index->hashes);
+    free(index->postings);
+  }
+  free(index->pending);
+  free(index);
+}
+
+int fingerprint_index_add(fingerprint_index_t *index, uint32_t track,
+                          float *spectrogram, unsigned int n_frames) {
+  if (index->addr != NULL) {
+    return -1;
+  }
+  unsigned int n_landmarks;
+  fingerprint_landmark_t *landmarks = fingerprint_extract_all(spectrogram,
+    n_frames, &n_landmarks);
+  if (landmarks == NULL) {
+    return -1;
+  }
+  if (index->pending_len + n_landmarks > index->pending_cap) {
+    uint64_t cap = index->pending_cap * 2;
+    if (cap < index->pending_len + n_landmarks) {
+      cap = index->pending_len + n_landmarks;
+    }
+    fingerprint_entry_t *pending = (fingerprint_entry_t*)realloc(
+      index->pending, sizeof(fingerprint_entry_t) * cap);
+    if (pending == NULL) {
+      free(landmarks);
+      return -1;
+    }
+    index->pending = pending;
+    index->pending_cap = cap;
+  }
+  for (unsigned int idx = 0; idx < n_landmarks; idx++) {
+    fingerprint_entry_t *entry = &index->pending[index->pending_len++];
+    entry->hash = landmarks[idx].hash;
+    entry->track = track;
+    entry->offset = landmarks[idx].offset;
+  }
+  free(landmarks);
+  return n_landmarks;
+}
+
+static int fingerprint_entry_compare(const void *a, const void *b) {
+  const fingerprint_entry_t *x = (const fingerprint_entry_t*)a;
+  const fingerprint_entry_t *y = (const fingerprint_entry_t*)b;
+  if (x->hash != y->hash) {
+    return x->hash < y->hash ? -1 : 1;
+  }
+  if (x->track != y->track) {
+    return x->track < y->track ? -1 : 1;
+  }
+  return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+bool fingerprint_index_build(fingerprint_index_t *index) {
+  if (index->addr != NULL) {
+    return false;
+  }
+  if (index->pending_len == 0) {
+    return true;
+  }
+  uint64_t len = index->len + index->pending_len;
+  uint32_t *hashes = (uint32_t*)malloc(sizeof(uint32_t) * len);
+  fingerprint_posting_t *postings = (fingerprint_posting_t*)malloc(
+    sizeof(fingerprint_posting_t) * len);
+  if (hashes == NULL || postings == NULL) {
+    free(hashes);
+    free(postings);
+    return false;
+  }
+  /* Sort the pending landmarks only, then merge them with the landmarks
+     already in the index in a single pass. */
+  fingerprint_entry_t *pending = index->pending;
+  qsort(pending, index->pending_len, sizeof(fingerprint_entry_t),
+    fingerprint_entry_compare);
+  uint64_t sorted_idx = 0;
+  uint64_t pending_idx = 0;
+  for (uint64_t idx = 0; idx < len; idx++) {
+    bool take_pending = sorted_idx == index->len;
+    if (!take_pending && pending_idx < index->pending_len) {
+      fingerprint_entry_t entry = {
+        index->hashes[sorted_idx], index->postings[sorted_idx].track,
+        index->postings[sorted_idx].offset
+      };
+      take_pending =
+        fingerprint_entry_compare(&pending[pending_idx], &entry) < 0;
+    }
+    if (take_pending) {
+      hashes[idx] = pending[pending_idx].hash;
+      postings[idx].track = pending[pending_idx].track;
+      postings[idx].offset = pending[pending_idx].offset;
+      pending_idx++;
+    } else {
+      hashes[idx] = index->hashes[sorted_idx];
+      postings[idx] = index->postings[sorted_idx];
+      sorted_idx++;
+    }
+  }
+  free(index->hashes);
+  free(index->postings);
+  index->hashes = hashes;
+  index->postings = postings;
+  index->len = len;
+  index->pending_len = 0;
+  return true;
+}
+
+uint64_t fingerprint_index_len(fingerprint_index_t *index) {
+  return index->len;
+}
+
+/**
+ * Flush the directory of a file, so a rename into it survives a crash.
+ */
+static bool fingerprint_sync_dir(const char *path) {
+  const char *slash = strrchr(path, '/');
+  char *dir_path = slash == NULL ? strdup(".") :
+    strndup(path, slash == path ? 1 : (size_t)(slash - path));
+  if (dir_path == NULL) {
+    return false;
+  }
+  int fd = open(dir_path, O_RDONLY | O_DIRECTORY);
+  free(dir_path);
+  if (fd < 0) {
+    return false;
+  }
+  bool success = fsync(fd) == 0;
+  close(fd);
+  return success;
+}
+
+bool fingerprint_index_save(fingerprint_index_t *index, const char *path) {
+  /* Write a temporary file next to the index and rename it over the index,
+     so processes which have the index mapped keep reading the old one. */
+  size_t path_len = strlen(path);
+  char *temp_path = (char*)malloc(path_len + sizeof(".XXXXXX"));
+  if (temp_path == NULL) {
+    return false;
+  }
+  memcpy(temp_path, path, path_len);
+  memcpy(&temp_path[path_len], ".XXXXXX", sizeof(".XXXXXX"));
+  int fd = mkstemp(temp_path);
+  if (fd < 0) {
+    free(temp_path);
+    return false;
+  }
+  /* mkstemp creates the file readable by its owner only. */
+  FILE *file = fchmod(fd, 0644) == 0 ? fdopen(fd, "wb") : NULL;
+  if (file == NULL) {
+    close(fd);
+    unlink(temp_path);
+    free(temp_path);
+    return false;
+  }
+  /* Pad the index to an even length so the postings stay aligned. */
+  uint64_t padding = index->len % 2;
+  fingerprint_file_header_t header;
+  memcpy(header.magic, FINGERPRINT_FILE_MAGIC, sizeof(header.magic));
+  header.version = FINGERPRINT_FILE_VERSION;
+  header.reserved = 0;
+  header.len = index->len;
+  uint32_t pad_hash = UINT32_MAX;
+  fingerprint_posting_t pad_posting = { UINT32_MAX, UINT32_MAX };
+  bool success = fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(index->hashes, sizeof(uint32_t), index->len, file) == index->len &&
+    fwrite(&pad_hash, sizeof(uint32_t), padding, file) == padding &&
+    fwrite(index->postings, sizeof(fingerprint_posting_t), index->len,
+      file) == index->len &&
+    fwrite(&pad_posting, sizeof(fingerprint_posting_t), padding,
+      file) == padding &&
+    fflush(file) == 0 && fsync(fd) == 0;
+  if (fclose(file) != 0) {
+    success = false;
+  }
+  if (success) {
+    success = rename(temp_path, path) == 0;
+  }
+  if (!success) {
+    unlink(temp_path);
+  }
+  free(temp_path);
+  return success && fingerprint_sync_dir(path);
+}
+
+/**
+ * Find the first position of a hash in the sorted hashes of an index.
+ */
+static uint64_t fingerprint_lower_bound(fingerprint_index_t *index,
+                                        uint32_t hash) {
+  uint64_t first = 0;
+  uint64_t len = index->len;
+  while (len > 0) {
+    uint64_t half = len / 2;
+    if (index->hashes[first + half] < hash) {
+      first += half + 1;
+      len -= half + 1;
+    } else {
+      len = half;
+    }
+  }
+  return first;
+}
+
+bool fingerprint_index_query(fingerprint_index_t *index, float *spectrogram,
+                             unsigned int n_frames,
+                             fingerprint_match_t *match) {
+  unsigned int n_landmarks;
+  fingerprint_landmark_t *landmarks = fingerprint_extract_all(spectrogram,
+    n_frames, &n_landmarks);
+  if (landmarks == NULL) {
+    return false;
+  }
+  /* Find the postings of every landmark. */
+  uint64_t *ranges = (uint64_t*)malloc(sizeof(uint64_t) * 2 *
+    (n_landmarks + 1));
+  if (ranges == NULL) {
+    free(landmarks);
+    return false;
+  }
+  uint64_t n_votes = 0;
+  for (unsigned int idx = 0; idx < n_landmarks; idx++) {
+    uint64_t first = fingerprint_lower_bound(index, landmarks[idx].hash);
+    uint64_t last = first;
+    while (last < index->len && index->hashes[last] == landmarks[idx].hash) {
+      last++;
+    }
+    ranges[idx * 2] = first;
+    ranges[idx * 2 + 1] = last;
+    n_votes += last - first;
+  }
+  /* Each posting votes for a track and the offset of the query in it. The
+     votes are counted in an open addressing histogram which is at most half
+     full. */
+  unsigned int bits = 4;
+  while ((UINT64_C(1) << bits) < n_votes * 2) {
+    bits++;
+  }
+  uint64_t mask = (UINT64_C(1) << bits) - 1;
+  uint64_t *votes = (uint64_t*)malloc(sizeof(uint64_t) * (mask + 1));
+  uint32_t *counts = (uint32_t*)calloc(mask + 1, sizeof(uint32_t));
+  if (votes == NULL || counts == NULL) {
+    free(votes);
+    free(counts);
+    free(ranges);
+    free(landmarks);
+    return false;
+  }
+  unsigned int best_votes = 0;
+  uint64_t best = 0;
+  for (unsigned int idx = 0; idx < n_landmarks; idx++) {
+    for (uint64_t pos = ranges[idx * 2]; pos < ranges[idx * 2 + 1]; pos++) {
+      int32_t offset = (int32_t)(index->postings[pos].offset -
+        landmarks[idx].offset);
+      uint64_t vote = ((uint64_t)index->postings[pos].track << 32) |
+        (uint32_t)offset;
+      uint64_t slot = (vote * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits);
+      while (counts[slot] != 0 && votes[slot] != vote) {
+        slot = (slot + 1) & mask;
+      }
+      votes[slot] = vote;
+      if (++counts[slot] > best_votes) {
+        best_votes = counts[slot];
+        best = vote;
+      }
+    }
+  }
+  free(counts);
+  free(votes);
+  free(ranges);
+  free(landmarks);
+  if (best_votes == 0) {
+    return false;
+  }
+  match->track = (uint32_t)(best >> 32);
+  match->offset = (int32_t)(uint32_t)best;
+  match->votes = best_votes;
+  return true;
+}
@@ -0,0 +1,237 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file fingerprint.h
+ *  @brief Public functions, macros and type definitions used for
+ *         fingerprinting spectrograms and matching fingerprints.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The number of frames on each side of a peak it has to dominate.
+ */
+#define FINGERPRINT_PEAK_FRAMES 5
+
+/**
+ * The number of bins on each side of a peak it has to dominate.
+ */
+#define FINGERPRINT_PEAK_BINS 3
+
+/**
+ * The smallest log power of a peak, in dB.
+ */
+#define FINGERPRINT_PEAK_FLOOR 10.0f
+
+/**
+ * The number of peaks each anchor peak is paired with.
+ */
+#define FINGERPRINT_FAN_OUT 5
+
+/**
+ * The largest distance between the peaks of a pair, in frames.
+ */
+#define FINGERPRINT_MAX_DT 63
+
+/**
+ * The largest distance between the peaks of a pair, in bins.
+ */
+#define FINGERPRINT_MAX_DF 31
+
+/**
+ * The version of the fingerprint index file format.
+ */
+#define FINGERPRINT_FILE_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A landmark is the hash of a pair of spectrogram peaks together with the
+ * frame of the first peak.
+ */
+typedef struct fingerprint_landmark {
+  uint32_t hash;
+  uint32_t offset;
+} fingerprint_landmark_t;
+
+/**
+ * The best match of a query.
+ */
+typedef struct fingerprint_match {
+  /* The matching track. */
+  uint32_t     track;
+  /* The frame of the track the query starts at. */
+  int32_t      offset;
+  /* The number of landmarks which agree on the track and offset. */
+  unsigned int votes;
+} fingerprint_match_t;
+
+/**
+ * A fingerprint index maps landmark hashes to the tracks and frames they
+ * were found at. The index is stored in sorted arrays so it can be saved
+ * and mapped back into memory as is.
+ */
+typedef struct fingerprint_index fingerprint_index_t;
+
+/**
+ * Extract the landmarks of a spectrogram.
+ *
+ * Peaks are the points of the spectrogram which are the largest within
+ * FINGERPRINT_PEAK_FRAMES frames and FINGERPRINT_PEAK_BINS bins and above
+ * FINGERPRINT_PEAK_FLOOR. Each peak is paired with the next
+ * FINGERPRINT_FAN_OUT peaks which are close enough to it.
+ *
+ * @param spectrogram A pointer to an array of n_frames spectrogram
+ *                    fragments of length 64 + 1, as generated by
+ *                    spectrograph_transform.
+ *
+ * @param n_frames The number of fragments.
+ *
+ * @param landmarks A pointer to an array which will store the landmarks.
+ *
+ * @param n_landmarks The length of the landmarks array.
+ *
+ * @return The number of landmarks found. When this is larger than
+ *         n_landmarks only the first n_landmarks landmarks were stored.
+ */
+unsigned int fingerprint_extract(float *spectrogram, unsigned int n_frames,
+                                 fingerprint_landmark_t *landmarks,
+                                 unsigned int n_landmarks);
+
+/**
+ * Create a new empty fingerprint index.
+ *
+ * @return A new fingerprint index.
+ */
+fingerprint_index_t* fingerprint_index_create(void);
+
+/**
+ * Load a fingerprint index saved by fingerprint_index_save. The file is
+ * mapped into memory and used in place, so the index is read-only.
+ *
+ * @param path The path of the file.
+ *
+ * @return A fingerprint index or NULL if the file is missing, truncated or
+ *         of a different version.
+ */
+fingerprint_index_t* fingerprint_index_load(const char *path);
+
+/**
+ * Release the resources allocated by a fingerprint index.
+ *
+ * @return Void.
+ */
+void                 fingerprint_index_destroy(fingerprint_index_t *index);
+
+/**
+ * Add the landmarks of a track to a fingerprint index. The landmarks can
+ * not be queried until the index is built.
+ *
+ * @param index A fingerprint index.
+ *
+ * @param track The identifier of the track.
+ *
+ * @param spectrogram A pointer to an array of n_frames spectrogram
+ *                    fragments of length 64 + 1.
+ *
+ * @param n_frames The number of fragments.
+ *
+ * @return The number of landmarks added or -1 on failure.
+ */
+int                  fingerprint_index_add(fingerprint_index_t *index,
+                                           uint32_t track,
+                                           float *spectrogram,
+                                           unsigned int n_frames);
+
+/**
+ * Sort the landmarks added since the index was last built into the index.
+ *
+ * Only the new landmarks are sorted; they are then merged with the sorted
+ * landmarks of the index in a single pass, so an incremental build is
+ * linear in the size of the index.
+ *
+ * @param index A fingerprint index.
+ *
+ * @return True on success.
+ */
+bool                 fingerprint_index_build(fingerprint_index_t *index);
+
+/**
+ * Get the number of landmarks in a fingerprint index.
+ *
+ * @param index A fingerprint index.
+ *
+ * @return The number of landmarks which can be queried.
+ */
+uint64_t             fingerprint_index_len(fingerprint_index_t *index);
+
+/**
+ * Save a fingerprint index to a file.
+ *
+ * The index is written to a temporary file in the same directory which is
+ * then renamed over the path, so indexes loaded from the path, by this
+ * process or any other, keep reading the previous file. The file is
+ * readable by every user and is flushed to disk, along with its directory,
+ * before the function returns.
+ *
+ * @param index A fingerprint index.
+ *
+ * @param path The path of the file.
+ *
+ * @return True on success.
+ */
+bool                 fingerprint_index_save(fingerprint_index_t *index,
+                                            const char *path);
+
+/**
+ * Find the track and offset which best match a query spectrogram.
+ *
+ * Every landmark of the query votes for the tracks and offsets at which its
+ * hash was found; the track and offset with the most votes wins.
+ *
+ * @param index A fingerprint index.
+ *
+ * @param spectrogram A pointer to an array of n_frames spectrogram
+ *                    fragments of length 64 + 1.
+ *
+ * @param n_frames The number of fragments.
+ *
+ * @param match The destination for the best match.
+ *
+ * @return True if a match was found.
+ */
+bool                 fingerprint_index_query(fingerprint_index_t *index,
+                                             float *spectrogram,
+                                             unsigned int n_frames,
+                                             fingerprint_match_t *match);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FINGERPRINT_H */
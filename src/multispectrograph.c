@@ -0,0 +1,231 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file multispectrograph.c
+ *  @brief Implements the multi-resolution spectrograph interface.
+ *
+ *  The input buffer holds the samples from the oldest sample still needed
+ *  by any resolution onwards. Samples which are no longer needed are only
+ *  discarded when the next samples do not fit. No more than the largest
+ *  frame is still needed at that point and the buffer holds several times
+ *  as much, so keeping the buffer compact costs a small fraction of the
+ *  conversion itself however small the blocks pushed are.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <stdlib.h>
+#include <string.h>
+
+/* Intel Integrated Performance Primitives */
+#include "ipp.h"
+
+/* Spectrograph Run-time */
+#include "multispectrograph.h"
+
+/* The number of input samples converted per block, in largest frames. */
+#define MULTISPECTROGRAPH_BLOCK_FRAMES 8
+
+typedef struct multispectrograph {
+  unsigned int    n_resolutions;
+  spectrograph_t *spectrographs[MULTISPECTROGRAPH_MAX_RESOLUTIONS];
+  unsigned int    n_samples[MULTISPECTROGRAPH_MAX_RESOLUTIONS];
+  unsigned int    hops[MULTISPECTROGRAPH_MAX_RESOLUTIONS];
+  uint64_t        next_frames[MULTISPECTROGRAPH_MAX_RESOLUTIONS];
+  unsigned int    max_samples;
+  /* Output */
+  float          *output_buffers;
+  unsigned int    output_stride;
+  /* Input */
+  float          *input_buffer;
+  unsigned int    input_capacity;
+  unsigned int    input_len;
+  uint64_t        input_base;
+} multispectrograph_t;
+
+/**
+ * Start a new signal.
+ */
+static void multispectrograph_reset(multispectrograph_t *msg) {
+  for (unsigned int idx = 0; idx < msg->n_resolutions; idx++) {
+    /* Center the first frame of every resolution on the same sample. */
+    msg->next_frames[idx] = (msg->max_samples - msg->n_samples[idx]) / 2;
+  }
+  msg->input_len = 0;
+  msg->input_base = 0;
+}
+
+multispectrograph_t* multispectrograph_create(unsigned int n_resolutions,
+                                              unsigned int *n_samples,
+                                              unsigned int *hops) {
+  if (n_resolutions == 0 ||
+      n_resolutions > MULTISPECTROGRAPH_MAX_RESOLUTIONS) {
+    return NULL;
+  }
+  multispectrograph_t *msg =
+    (multispectrograph_t*)calloc(1, sizeof(multispectrograph_t));
+  if (msg == NULL) {
+    return NULL;
+  }
+  unsigned int max_samples = 0;
+  for (unsigned int idx = 0; idx < n_resolutions; idx++) {
+    if (n_samples[idx] > max_samples) {
+      max_samples = n_samples[idx];
+    }
+  }
+  for (unsigned int idx = 0; idx < n_resolutions; idx++) {
+    msg->spectrographs[idx] = spectrograph_create_size(n_samples[idx]);
+    if (msg->spectrographs[idx] == NULL || hops[idx] == 0) {
+      msg->n_resolutions = idx + 1;
+      multispectrograph_destroy(msg);
+      return NULL;
+    }
+    msg->n_samples[idx] = n_samples[idx];
+    msg->hops[idx] = hops[idx];
+  }
+  msg->n_resolutions = n_resolutions;
+  msg->max_samples = max_samples;
+  /* Keep every fragment aligned so streaming stores can be used, with room
+     for the complex output mode. */
+  msg->output_stride = max_samples + 16;
+  msg->output_buffers = (float*)aligned_alloc(32,
+    sizeof(float) * msg->output_stride * n_resolutions);
+  msg->input_capacity = max_samples * (MULTISPECTROGRAPH_BLOCK_FRAMES + 1);
+  msg->input_buffer = (float*)aligned_alloc(32,
+    sizeof(float) * msg->input_capacity);
+  if (msg->output_buffers == NULL || msg->input_buffer == NULL) {
+    multispectrograph_destroy(msg);
+    return NULL;
+  }
+  multispectrograph_reset(msg);
+  return msg;
+}
+
+void multispectrograph_destroy(multispectrograph_t *msg) {
+  for (unsigned int idx = 0; idx < msg->n_resolutions; idx++) {
+    if (msg->spectrographs[idx] != NULL) {
+      spectrograph_destroy(msg->spectrographs[idx]);
+    }
+  }
+  free(msg->output_buffers);
+  free(msg->input_buffer);
+  free(msg);
+}
+
+spectrograph_t* multispectrograph_resolution(multispectrograph_t *msg,
+                                             unsigned int resolution) {
+  return msg->spectrographs[resolution];
+}
+
+/**
+ * Transform the complete frames in timestamp order, across all resolutions.
+ * Unless flushing, stop at the first frame which is not complete yet so
+ * that later frames of the smaller resolutions are held back.
+ */
+static int multispectrograph_emit(multispectrograph_t *msg,
+                                  multispectrograph_callback_t callback,
+                                  void *context, bool flush) {
+  int n_frames = 0;
+  uint64_t end = msg->input_base + msg->input_len;
+  for (;;) {
+    int best = -1;
+    uint64_t best_timestamp = 0;
+    for (unsigned int idx = 0; idx < msg->n_resolutions; idx++) {
+      uint64_t timestamp = msg->next_frames[idx] + msg->n_samples[idx] / 2;
+      bool complete = msg->next_frames[idx] + msg->n_samples[idx] <= end;
+      if ((complete || !flush) &&
+          (best < 0 || timestamp < best_timestamp)) {
+        best = idx;
+        best_timestamp = timestamp;
+      }
+    }
+    if (best < 0 || msg->next_frames[best] + msg->n_samples[best] > end) {
+      break;
+    }
+    float *frame =
+      &msg->input_buffer[msg->next_frames[best] - msg->input_base];
+    float *output = &msg->output_buffers[best * msg->output_stride];
+    if (!spectrograph_transform(msg->spectrographs[best], frame, output)) {
+      return -1;
+    }
+    callback(context, best, best_timestamp, output);
+    msg->next_frames[best] += msg->hops[best];
+    n_frames++;
+  }
+  return n_frames;
+}
+
+/**
+ * Discard the samples no resolution needs anymore.
+ */
+static void multispectrograph_compact(multispectrograph_t *msg) {
+  uint64_t oldest = msg->next_frames[0];
+  for (unsigned int idx = 1; idx < msg->n_resolutions; idx++) {
+    if (msg->next_frames[idx] < oldest) {
+      oldest = msg->next_frames[idx];
+    }
+  }
+  unsigned int discard = oldest - msg->input_base < msg->input_len ?
+    oldest - msg->input_base : msg->input_len;
+  msg->input_len -= discard;
+  memmove(msg->input_buffer, &msg->input_buffer[discard],
+    sizeof(float) * msg->input_len);
+  msg->input_base += discard;
+}
+
+int multispectrograph_push(multispectrograph_t *msg, short *input,
+                           unsigned int n_input,
+                           multispectrograph_callback_t callback,
+                           void *context) {
+  int n_frames = 0;
+  while (n_input > 0) {
+    if (msg->input_len + n_input > msg->input_capacity) {
+      multispectrograph_compact(msg);
+    }
+    /* Convert as much of the input as fits, once for every resolution. */
+    unsigned int len = msg->input_capacity - msg->input_len;
+    if (len > n_input) {
+      len = n_input;
+    }
+    IppStatus status = ippsConvert_16s32f(input,
+      &msg->input_buffer[msg->input_len], len);
+    if (status != ippStsNoErr) {
+      return -1;
+    }
+    msg->input_len += len;
+    input += len;
+    n_input -= len;
+    int n = multispectrograph_emit(msg, callback, context, false);
+    if (n < 0) {
+      return -1;
+    }
+    n_frames += n;
+  }
+  return n_frames;
+}
+
+int multispectrograph_flush(multispectrograph_t *msg,
+                            multispectrograph_callback_t callback,
+                            void *context) {
+  int n_frames = multispectrograph_emit(msg, callback, context, true);
+  multispectrograph_reset(msg);
+  return n_frames;
+}
@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file multispectrograph.h
+ *  @brief Public functions, macros and type definitions used for
+ *         generating spectrograms at several resolutions at once.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#ifndef MULTISPECTROGRAPH_H
+#define MULTISPECTROGRAPH_H
+
+#include <stdint.h>
+
+#include "spectrograph.h"
+
+/**
+ * The largest number of resolutions of a multi-resolution spectrograph.
+ */
+#define MULTISPECTROGRAPH_MAX_RESOLUTIONS 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A multi-resolution spectrograph analyzes a signal at several frame sizes
+ * at once.
+ *
+ * Every resolution reads its frames from a single buffer of the input
+ * signal, which is converted to floats once. The frames of every resolution
+ * are centered on the same grid: the first frame of each resolution is
+ * centered on sample n / 2, where n is the largest frame size, so frames of
+ * different resolutions with the same timestamp describe the same instant.
+ */
+typedef struct multispectrograph multispectrograph_t;
+
+/**
+ * The function called with every spectrogram fragment.
+ *
+ * @param context The context given to multispectrograph_push.
+ *
+ * @param resolution The index of the resolution of the fragment.
+ *
+ * @param timestamp The index of the input sample the frame is centered on.
+ *
+ * @param spectrum The spectrogram fragment, of length
+ *                 spectrograph_output_len(n_samples), or
+ *                 spectrograph_complex_output_len(n_samples) for a
+ *                 resolution in the complex output mode. The fragment is
+ *                 only valid for the duration of the call.
+ *
+ * @return Void.
+ */
+typedef void (*multispectrograph_callback_t)(void *context,
+                                             unsigned int resolution,
+                                             uint64_t timestamp,
+                                             float *spectrum);
+
+/**
+ * Create a new multi-resolution spectrograph.
+ *
+ * @param n_resolutions The number of resolutions, at most
+ *                      MULTISPECTROGRAPH_MAX_RESOLUTIONS.
+ *
+ * @param n_samples The number of samples per frame of each resolution.
+ *
+ * @param hops The number of samples between the frames of each resolution.
+ *
+ * @return A new multi-resolution spectrograph or NULL on failure.
+ */
+multispectrograph_t* multispectrograph_create(unsigned int n_resolutions,
+                                              unsigned int *n_samples,
+                                              unsigned int *hops);
+
+/**
+ * Release the resources allocated by a multi-resolution spectrograph.
+ *
+ * @return Void.
+ */
+void                 multispectrograph_destroy(multispectrograph_t *msg);
+
+/**
+ * Get the spectrograph of one resolution, for example to set its cache
+ * policy, energy gate or normalization.
+ *
+ * @param msg A multi-resolution spectrograph.
+ *
+ * @param resolution The index of the resolution.
+ *
+ * @return The spectrograph of the resolution.
+ */
+spectrograph_t*      multispectrograph_resolution(multispectrograph_t *msg,
+                                                  unsigned int resolution);
+
+/**
+ * Analyze a block of the input signal.
+ *
+ * The frames which are complete once the block is appended are transformed
+ * and given to the callback in timestamp order across all resolutions: a
+ * frame is held back until every frame with an earlier timestamp is
+ * complete. Samples still needed by later frames are kept until the next
+ * call.
+ *
+ * @param msg A multi-resolution spectrograph.
+ *
+ * @param input A pointer to an array of 16 bit samples of length n_input.
+ *
+ * @param n_input The number of input samples.
+ *
+ * @param callback The function called with every spectrogram fragment.
+ *
+ * @param context The context given to the callback.
+ *
+ * @return The number of fragments generated or -1 on failure.
+ */
+int                  multispectrograph_push(multispectrograph_t *msg,
+                                            short *input,
+                                            unsigned int n_input,
+                                            multispectrograph_callback_t
+                                              callback,
+                                            void *context);
+
+/**
+ * Finish the input signal.
+ *
+ * The frames which are complete but were held back for the frames of the
+ * larger resolutions are transformed and given to the callback in
+ * timestamp order. The incomplete frames are dropped and the next block
+ * pushed starts a new signal.
+ *
+ * @param msg A multi-resolution spectrograph.
+ *
+ * @param callback The function called with every spectrogram fragment.
+ *
+ * @param context The context given to the callback.
+ *
+ * @return The number of fragments generated or -1 on failure.
+ */
+int                  multispectrograph_flush(multispectrograph_t *msg,
+                                             multispectrograph_callback_t
+                                               callback,
+                                             void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MULTISPECTROGRAPH_H */
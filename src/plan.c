@@ -0,0 +1,168 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file plan.c
+ *  @brief Implements the plan interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* Spectrograph Run-time */
+#include "dsp.h"
+#include "plan.h"
+
+static pthread_mutex_t plan_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static plan_t *plan_cache = NULL;
+
+static bool plan_key_equals(plan_key_t *a, plan_key_t *b) {
+  return a->n_samples == b->n_samples && a->window == b->window &&
+    a->backend == b->backend && a->isa == b->isa;
+}
+
+static int plan_order(unsigned int n_samples) {
+  if (n_samples < PLAN_MIN_SAMPLES || n_samples > PLAN_MAX_SAMPLES ||
+      (n_samples & (n_samples - 1)) != 0) {
+    return -1;
+  }
+  int order = 0;
+  while ((1u << order) < n_samples) {
+    order++;
+  }
+  return order;
+}
+
+static void plan_free(plan_t *plan) {
+  free(plan->tables);
+  ippFree(plan->fft_spec_buffer);
+  free(plan);
+}
+
+static plan_t* plan_create(plan_key_t *key) {
+  int order = plan_order(key->n_samples);
+  if (order < 0 || key->window != PLAN_WINDOW_HANN ||
+      key->backend != PLAN_BACKEND_IPP || key->isa != PLAN_ISA_AVX) {
+    return NULL;
+  }
+  plan_t *plan = (plan_t*)calloc(1, sizeof(plan_t));
+  if (plan == NULL) {
+    return NULL;
+  }
+  plan->key = *key;
+  unsigned int n_samples = key->n_samples;
+  /* Initialize the tables. */
+  float *tables = (float*)aligned_alloc(32, sizeof(float) * n_samples * 2);
+  if (tables == NULL) {
+    plan_free(plan);
+    return NULL;
+  }
+  plan->tables = tables;
+  for (unsigned int idx = 0; idx < n_samples; idx++) {
+    tables[idx] = hann_func(idx, n_samples);
+    tables[n_samples + idx] = 1.0f / n_samples;
+  }
+  plan->window = tables;
+  plan->power_spec_coeff = &tables[n_samples];
+  /* Initialize the FFT run-time. */
+  int init_buff_len, spec_buff_len;
+  IppStatus status = ippsFFTGetSize_C_32fc(order, IPP_FFT_NODIV_BY_ANY,
+    ippAlgHintNone, &spec_buff_len, &init_buff_len,
+    &plan->fft_work_buffer_len);
+  if (status != ippStsNoErr) {
+    plan_free(plan);
+    return NULL;
+  }
+  plan->fft_spec_buffer = ippsMalloc_8u(spec_buff_len);
+  if (plan->fft_spec_buffer == NULL) {
+    plan_free(plan);
+    return NULL;
+  }
+  Ipp8u *init_buffer = NULL;
+  if (init_buff_len > 0) {
+    init_buffer = ippsMalloc_8u(init_buff_len);
+    if (init_buffer == NULL) {
+      plan_free(plan);
+      return NULL;
+    }
+  }
+  status = ippsFFTInit_C_32fc(&plan->fft_spec, order, IPP_FFT_NODIV_BY_ANY,
+    ippAlgHintNone, plan->fft_spec_buffer, init_buffer);
+  if (init_buffer != NULL) {
+    ippFree(init_buffer);
+  }
+  if (status != ippStsNoErr) {
+    plan_free(plan);
+    return NULL;
+  }
+  return plan;
+}
+
+static plan_t* plan_cache_find(plan_key_t *key) {
+  for (plan_t *plan = plan_cache; plan != NULL; plan = plan->next) {
+    if (plan_key_equals(&plan->key, key)) {
+      return plan;
+    }
+  }
+  return NULL;
+}
+
+plan_t* plan_acquire(unsigned int n_samples, plan_window_t window) {
+  plan_key_t key = { n_samples, window, PLAN_BACKEND_IPP, PLAN_ISA_AVX };
+  pthread_mutex_lock(&plan_cache_lock);
+  plan_t *plan = plan_cache_find(&key);
+  if (plan == NULL) {
+    plan = plan_create(&key);
+    if (plan != NULL) {
+      plan->next = plan_cache;
+      plan_cache = plan;
+    }
+  }
+  if (plan != NULL) {
+    plan->refs++;
+  }
+  pthread_mutex_unlock(&plan_cache_lock);
+  return plan;
+}
+
+void plan_release(plan_t *plan) {
+  pthread_mutex_lock(&plan_cache_lock);
+  plan->refs--;
+  pthread_mutex_unlock(&plan_cache_lock);
+}
+
+void plan_cache_clear(void) {
+  pthread_mutex_lock(&plan_cache_lock);
+  plan_t **link = &plan_cache;
+  while (*link != NULL) {
+    plan_t *plan = *link;
+    if (plan->refs == 0) {
+      *link = plan->next;
+      plan_free(plan);
+    } else {
+      link = &plan->next;
+    }
+  }
+  pthread_mutex_unlock(&plan_cache_lock);
+}
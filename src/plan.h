@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file plan.h
+ *  @brief Public functions, macros and type definitions used for
+ *         sharing FFT plans and precomputed tables.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#ifndef PLAN_H
+#define PLAN_H
+
+/* Intel Integrated Performance Primitives */
+#include "ipp.h"
+
+/**
+ * The smallest supported number of samples per frame.
+ */
+#define PLAN_MIN_SAMPLES 128
+
+/**
+ * The largest supported number of samples per frame.
+ */
+#define PLAN_MAX_SAMPLES 65536
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The windowing functions.
+ */
+typedef enum plan_window {
+  PLAN_WINDOW_HANN
+} plan_window_t;
+
+/**
+ * The FFT back-ends.
+ */
+typedef enum plan_backend {
+  PLAN_BACKEND_IPP
+} plan_backend_t;
+
+/**
+ * The instruction sets the vector routines are written for.
+ */
+typedef enum plan_isa {
+  PLAN_ISA_AVX
+} plan_isa_t;
+
+/**
+ * The key a plan is cached under.
+ */
+typedef struct plan_key {
+  unsigned int   n_samples;
+  plan_window_t  window;
+  plan_backend_t backend;
+  plan_isa_t     isa;
+} plan_key_t;
+
+/**
+ * A plan holds the FFT specification and the precomputed tables for one
+ * frame size and window. Plans are read-only once created, so a single plan
+ * is shared by every spectrograph of the process which uses the same key.
+ */
+typedef struct plan {
+  plan_key_t          key;
+  unsigned int        refs;
+  /* Constants */
+  float              *window;
+  float              *power_spec_coeff;
+  /* FFT */
+  IppsFFTSpec_C_32fc *fft_spec;
+  int                 fft_work_buffer_len;
+  /* Storage */
+  float              *tables;
+  Ipp8u              *fft_spec_buffer;
+  struct plan        *next;
+} plan_t;
+
+/**
+ * Acquire the plan for a frame size and window, creating it the first time
+ * it is needed. Each acquired plan has to be released.
+ *
+ * @param n_samples The number of samples per frame. Must be a power of two
+ *                  between PLAN_MIN_SAMPLES and PLAN_MAX_SAMPLES.
+ *
+ * @param window The windowing function.
+ *
+ * @return A plan or NULL on failure.
+ */
+plan_t* plan_acquire(unsigned int n_samples, plan_window_t window);
+
+/**
+ * Release a plan. The plan stays cached until plan_cache_clear is called.
+ *
+ * @param plan A plan.
+ *
+ * @return Void.
+ */
+void    plan_release(plan_t *plan);
+
+/**
+ * Free every cached plan which is not in use.
+ *
+ * @return Void.
+ */
+void    plan_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLAN_H */
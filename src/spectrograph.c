@@ -25,6 +25,8 @@
  */
 
 /* C Run-time */
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -32,104 +34,135 @@
 #include "ipp.h"
 
 /* Spectrograph Run-time */
-#include "dsp.h"
+#include "decimator.h"
+#include "plan.h"
 #include "spectrograph.h"
 #include "vector.h"
 
+/* The number of frames ahead of the current one to prefetch. */
+#define SPECTROGRAPH_PREFETCH_FRAMES 4
+
+/* The floor of the power spectrum. */
+#define SPECTROGRAPH_POWER_FLOOR 1e-30
+
+/* The magic number at the start of a normalization file. */
+#define SPECTROGRAPH_NORM_FILE_MAGIC "SPECNORM"
+
 typedef struct spectrograph {
+  plan_t             *plan;
+  unsigned int        n_samples;
+  unsigned int        n_bins;
   float              *constant_buffers;
   Ipp32fc            *io_buffers;
   Ipp8u              *fft_buffers;
   float              *work_buffers;
+  /* Framing */
+  float              *frame_buffer;
+  unsigned int        frame_len;
   /* Constants */
   float              *hann_wnd;
   float              *power_spec_coeff;
+  float              *noise_profile;
+  /* Normalization */
+  float              *norm_mean;
+  float              *norm_var;
+  float              *norm_scale;
   /* FFT */
   Ipp32fc            *fft_input_buffer;
   Ipp32fc            *fft_output_buffer;
   IppsFFTSpec_C_32fc *fft_spec;
-  Ipp8u              *fft_spec_buffer;
   Ipp8u              *fft_work_buffer;
+  /* Options */
+  spectrograph_output_mode_t output_mode;
+  unsigned int        output_len;
+  spectrograph_cache_policy_t cache_policy;
+  float               gate_threshold;
+  spectrograph_normalization_t normalization;
+  float               norm_rate;
+  bool                norm_seeded;
+  /* Statistics */
+  bool                gated;
+  unsigned long       frames;
+  unsigned long       gated_frames;
 } spectrograph_t;
 
 spectrograph_t* spectrograph_create(void) {
+  return spectrograph_create_size(128);
+}
+
+spectrograph_t* spectrograph_create_size(unsigned int n_samples) {
   spectrograph_t *sg = (spectrograph_t*)malloc(sizeof(spectrograph_t));
   if (sg == NULL) {
     return NULL;
   }
+  /* Share the FFT specification and the tables with the other instances. */
+  plan_t *plan = plan_acquire(n_samples, PLAN_WINDOW_HANN);
+  if (plan == NULL) {
+    free(sg);
+    return NULL;
+  }
+  sg->plan = plan;
+  sg->n_samples = n_samples;
+  sg->n_bins = spectrograph_output_len(n_samples);
+  sg->hann_wnd = plan->window;
+  sg->power_spec_coeff = plan->power_spec_coeff;
+  sg->fft_spec = plan->fft_spec;
   /* Initialize the FFT run-time. */
-  Ipp32fc *io_buffers = ippsMalloc_32fc(128 * 2);
+  Ipp32fc *io_buffers = ippsMalloc_32fc(n_samples * 2);
   if (io_buffers == NULL) {
+    plan_release(plan);
     free(sg);
     return NULL;
   }
   sg->io_buffers = io_buffers;
   sg->fft_input_buffer = io_buffers;
-  sg->fft_output_buffer = &io_buffers[128];
-  int init_buff_len, spec_buff_len, work_buff_len;
-  IppStatus status = ippsFFTGetSize_C_32fc(7, IPP_FFT_NODIV_BY_ANY,
-    ippAlgHintNone, &spec_buff_len, &init_buff_len, &work_buff_len);
-  if (status != ippStsNoErr) {
-    ippFree(io_buffers);
-    free(sg);
-    return NULL;
-  }
-  Ipp8u *fft_buffers = ippsMalloc_8u(spec_buff_len + work_buff_len);
+  sg->fft_output_buffer = &io_buffers[n_samples];
+  Ipp8u *fft_buffers = ippsMalloc_8u(plan->fft_work_buffer_len);
   if (fft_buffers == NULL) {
     ippFree(io_buffers);
+    plan_release(plan);
     free(sg);
     return NULL;
   }
   sg->fft_buffers = fft_buffers;
-  sg->fft_spec_buffer = fft_buffers;
-  sg->fft_work_buffer = &fft_buffers[spec_buff_len];
-  Ipp8u *init_buffer = NULL;
-  if (init_buff_len > 0) {
-    init_buffer = ippsMalloc_8u(init_buff_len);
-    if (init_buffer == NULL) {
-      ippFree(io_buffers);
-      ippFree(fft_buffers);
-      free(sg);
-      return NULL;
-    }
-  }
-  status = ippsFFTInit_C_32fc(&sg->fft_spec, 7, IPP_FFT_NODIV_BY_ANY,
-    ippAlgHintNone, sg->fft_spec_buffer, init_buffer);
-  if (init_buffer != NULL) {
-    ippFree(init_buffer);
-  }
-  if (status != ippStsNoErr) {
-    ippFree(io_buffers);
-    ippFree(fft_buffers);
-    free(sg);
-    return NULL;
-  }
-  /* Initialize the spectrograph run-time. */
-  unsigned int constants_buffer_size = sizeof(float) * 128 * 2;
+  sg->fft_work_buffer = fft_buffers;
+  /* Initialize the spectrograph run-time. Every per bin vector is padded
+     to keep the next one aligned. */
+  unsigned int bins_stride = n_samples / 2 + 8;
+  unsigned int constants_buffer_size = sizeof(float) * bins_stride * 4;
   float *constant_buffers = (float*)aligned_alloc(32, constants_buffer_size);
   if (constant_buffers == NULL) {
     ippFree(io_buffers);
     ippFree(fft_buffers);
+    plan_release(plan);
     free(sg);
     return NULL;
   }
   sg->constant_buffers = constant_buffers;
-  sg->hann_wnd = constant_buffers;
-  sg->power_spec_coeff = &constant_buffers[128];
-  for (unsigned int idx = 0; idx < 128; idx++) {
-    sg->hann_wnd[idx] = hann_func(idx, 128);
-    sg->power_spec_coeff[idx] = 0.0078125f;
-  }
-  unsigned int work_buffer_size = sizeof(float) * 128 * 3;
+  sg->noise_profile = constant_buffers;
+  sg->norm_mean = &constant_buffers[bins_stride];
+  sg->norm_var = &constant_buffers[bins_stride * 2];
+  sg->norm_scale = &constant_buffers[bins_stride * 3];
+  spectrograph_set_noise_profile(sg, NULL);
+  spectrograph_set_normalization(sg, SPECTROGRAPH_NORM_NONE, 0);
+  unsigned int work_buffer_size = sizeof(float) * n_samples * 4;
   float *work_buffers = (float*)aligned_alloc(32, work_buffer_size);
   if (work_buffers == NULL) {
     ippFree(io_buffers);
     ippFree(fft_buffers);
     free(constant_buffers);
+    plan_release(plan);
     free(sg);
     return NULL;
   }
   sg->work_buffers = work_buffers;
+  sg->frame_buffer = &work_buffers[n_samples * 3];
+  sg->frame_len = 0;
+  spectrograph_set_output_mode(sg, SPECTROGRAPH_OUTPUT_LOG_POWER);
+  sg->cache_policy = SPECTROGRAPH_CACHE_LATENCY;
+  sg->gate_threshold = 0;
+  sg->gated = false;
+  spectrograph_reset_stats(sg);
   return sg;
 }
 
@@ -138,25 +171,213 @@ void spectrograph_destroy(spectrograph_t *sg) {
   ippFree(sg->fft_buffers);
   free(sg->constant_buffers);
   free(sg->work_buffers);
+  plan_release(sg->plan);
   free(sg);
 }
 
-bool spectrograph_transform(spectrograph_t *sg, float *input, float *output) {
+unsigned int spectrograph_n_samples(spectrograph_t *sg) {
+  return sg->n_samples;
+}
+
+void spectrograph_set_cache_policy(spectrograph_t *sg,
+                                   spectrograph_cache_policy_t policy) {
+  sg->cache_policy = policy;
+}
+
+void spectrograph_set_output_mode(spectrograph_t *sg,
+                                  spectrograph_output_mode_t mode) {
+  sg->output_mode = mode;
+  sg->output_len = mode == SPECTROGRAPH_OUTPUT_COMPLEX ?
+    spectrograph_complex_output_len(sg->n_samples) : sg->n_bins;
+}
+
+void spectrograph_set_gate(spectrograph_t *sg, float threshold) {
+  sg->gate_threshold = threshold;
+}
+
+void spectrograph_set_noise_profile(spectrograph_t *sg, float *spectrum) {
+  for (unsigned int idx = 0; idx < sg->n_bins; idx++) {
+    sg->noise_profile[idx] = spectrum != NULL ?
+      spectrum[idx] : 10 * log10f(SPECTROGRAPH_POWER_FLOOR);
+  }
+}
+
+void spectrograph_set_normalization(spectrograph_t *sg,
+                                    spectrograph_normalization_t mode,
+                                    float decay) {
+  if (mode != SPECTROGRAPH_NORM_FROZEN) {
+    for (unsigned int idx = 0; idx < sg->n_bins; idx++) {
+      sg->norm_mean[idx] = 0;
+      sg->norm_var[idx] = 1;
+    }
+    sg->norm_seeded = false;
+  }
+  for (unsigned int idx = 0; idx < sg->n_bins; idx++) {
+    sg->norm_scale[idx] = 1 / sqrtf(sg->norm_var[idx] + VEC_CMVN_EPSILON);
+  }
+  sg->normalization = mode;
+  sg->norm_rate = 1 - decay;
+}
+
+bool spectrograph_load_normalization(spectrograph_t *sg, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  /* Read into the work buffers so a bad file leaves the statistics be. */
+  float *mean = sg->work_buffers;
+  float *var = &sg->work_buffers[sg->n_bins];
+  char magic[8];
+  uint32_t version, n_bins;
+  bool success = fread(magic, sizeof(magic), 1, file) == 1 &&
+    memcmp(magic, SPECTROGRAPH_NORM_FILE_MAGIC, sizeof(magic)) == 0 &&
+    fread(&version, sizeof(version), 1, file) == 1 &&
+    version == SPECTROGRAPH_NORM_FILE_VERSION &&
+    fread(&n_bins, sizeof(n_bins), 1, file) == 1 && n_bins == sg->n_bins &&
+    fread(mean, sizeof(float), n_bins, file) == n_bins &&
+    fread(var, sizeof(float), n_bins, file) == n_bins;
+  fclose(file);
+  if (!success) {
+    return false;
+  }
+  memcpy(sg->norm_mean, mean, sizeof(float) * n_bins);
+  memcpy(sg->norm_var, var, sizeof(float) * n_bins);
+  spectrograph_set_normalization(sg, SPECTROGRAPH_NORM_FROZEN, 0);
+  return true;
+}
+
+bool spectrograph_save_normalization(spectrograph_t *sg, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  uint32_t version = SPECTROGRAPH_NORM_FILE_VERSION;
+  uint32_t n_bins = sg->n_bins;
+  bool success =
+    fwrite(SPECTROGRAPH_NORM_FILE_MAGIC, 8, 1, file) == 1 &&
+    fwrite(&version, sizeof(version), 1, file) == 1 &&
+    fwrite(&n_bins, sizeof(n_bins), 1, file) == 1 &&
+    fwrite(sg->norm_mean, sizeof(float), n_bins, file) == n_bins &&
+    fwrite(sg->norm_var, sizeof(float), n_bins, file) == n_bins;
+  if (fclose(file) != 0) {
+    success = false;
+  }
+  return success;
+}
+
+bool spectrograph_gated(spectrograph_t *sg) {
+  return sg->gated;
+}
+
+void spectrograph_get_stats(spectrograph_t *sg, spectrograph_stats_t *stats) {
+  stats->frames = sg->frames;
+  stats->gated_frames = sg->gated_frames;
+}
+
+void spectrograph_reset_stats(spectrograph_t *sg) {
+  sg->frames = 0;
+  sg->gated_frames = 0;
+}
+
+/**
+ * Write a spectrum around the cache. The output does not have to be
+ * aligned: the floats before its first 32 byte boundary and after its last
+ * one are written through the cache.
+ */
+static void spectrograph_stream(spectrograph_t *sg, float *buffer,
+                                float *output) {
+  unsigned int head = ((32 - ((uintptr_t)output & 31)) & 31) / sizeof(float);
+  if (head > sg->n_bins) {
+    head = sg->n_bins;
+  }
+  unsigned int body = (sg->n_bins - head) & ~7u;
+  for (unsigned int idx = 0; idx < head; idx++) {
+    output[idx] = buffer[idx];
+  }
+  if (body > 0) {
+    vec_stream(&buffer[head], &output[head], body);
+  }
+  for (unsigned int idx = head + body; idx < sg->n_bins; idx++) {
+    output[idx] = buffer[idx];
+  }
+}
+
+/**
+ * Normalize a log power spectrum. The statistics are only updated when
+ * update is set and the normalization is running.
+ */
+static void spectrograph_normalize(spectrograph_t *sg, float *input,
+                                   float *output, bool update) {
+  unsigned int half = sg->n_samples / 2;
+  if (sg->normalization == SPECTROGRAPH_NORM_RUNNING && update) {
+    if (!sg->norm_seeded) {
+      /* Start the running mean from the first fragment. */
+      memcpy(sg->norm_mean, input, sizeof(float) * sg->n_bins);
+      sg->norm_seeded = true;
+    }
+    for (unsigned int idx = 0; idx < half; idx += 64) {
+      vec_cmvn_64(&input[idx], &output[idx], &sg->norm_mean[idx],
+        &sg->norm_var[idx], sg->norm_rate);
+    }
+    /* Handle the final sample. */
+    float diff = input[half] - sg->norm_mean[half];
+    sg->norm_mean[half] += sg->norm_rate * diff;
+    sg->norm_var[half] = (1 - sg->norm_rate) *
+      (sg->norm_var[half] + sg->norm_rate * diff * diff);
+    output[half] = (input[half] - sg->norm_mean[half]) /
+      sqrtf(sg->norm_var[half] + VEC_CMVN_EPSILON);
+    return;
+  }
+  if (sg->normalization == SPECTROGRAPH_NORM_RUNNING) {
+    for (unsigned int idx = 0; idx < sg->n_bins; idx++) {
+      sg->norm_scale[idx] = 1 / sqrtf(sg->norm_var[idx] + VEC_CMVN_EPSILON);
+    }
+  }
+  for (unsigned int idx = 0; idx < half; idx += 64) {
+    vec_normalize_64(&input[idx], &output[idx], &sg->norm_mean[idx],
+      &sg->norm_scale[idx]);
+  }
+  output[half] = (input[half] - sg->norm_mean[half]) * sg->norm_scale[half];
+}
+
+/**
+ * Generate a spectrogram fragment for one frame which is already resident in
+ * an aligned buffer. The frame is not modified.
+ */
+static bool spectrograph_transform_frame(spectrograph_t *sg, float *frame,
+                                         float *output) {
+  unsigned int n_samples = sg->n_samples;
+  unsigned int half = n_samples / 2;
   float *buffer = sg->work_buffers;
-  vec_copy_16(input, buffer);
-  vec_copy_16(&input[16], &buffer[16]);
-  vec_copy_16(&input[32], &buffer[32]);
-  vec_copy_16(&input[48], &buffer[48]);
-  vec_copy_16(&input[64], &buffer[64]);
-  vec_copy_16(&input[80], &buffer[80]);
-  vec_copy_16(&input[96], &buffer[96]);
-  vec_copy_16(&input[112], &buffer[112]);
+  bool streaming = sg->cache_policy == SPECTROGRAPH_CACHE_THROUGHPUT;
+  sg->frames++;
+  /* Skip the FFT for frames below the energy gate. */
+  sg->gated = sg->gate_threshold > 0 &&
+    vec_dot(frame, frame, n_samples) < sg->gate_threshold * n_samples;
+  if (sg->gated) {
+    sg->gated_frames++;
+    if (sg->output_mode == SPECTROGRAPH_OUTPUT_COMPLEX) {
+      memset(output, 0, sizeof(float) * sg->output_len);
+    } else if (sg->normalization != SPECTROGRAPH_NORM_NONE) {
+      spectrograph_normalize(sg, sg->noise_profile, streaming ? buffer : output,
+        false);
+      if (streaming) {
+        spectrograph_stream(sg, buffer, output);
+      }
+    } else if (streaming) {
+      spectrograph_stream(sg, sg->noise_profile, output);
+    } else {
+      memcpy(output, sg->noise_profile, sizeof(float) * sg->n_bins);
+    }
+    return true;
+  }
   /* Apply the hanning window to the input frame. */
-  vec_mul_64(sg->hann_wnd, buffer, buffer);
-  vec_mul_64(&sg->hann_wnd[64], &buffer[64], &buffer[64]);
+  for (unsigned int idx = 0; idx < n_samples; idx += 64) {
+    vec_mul_64(&sg->hann_wnd[idx], &frame[idx], &buffer[idx]);
+  }
   /* Perform the FFT */
-  memset(sg->fft_input_buffer, 0, sizeof(Ipp32fc) * 128);
-  for (unsigned int idx = 0; idx < 128; idx++) {
+  memset(sg->fft_input_buffer, 0, sizeof(Ipp32fc) * n_samples);
+  for (unsigned int idx = 0; idx < n_samples; idx++) {
     sg->fft_input_buffer[idx].re = buffer[idx];
   }
   IppStatus status = ippsFFTFwd_CToC_32fc(sg->fft_input_buffer,
@@ -164,30 +385,90 @@ bool spectrograph_transform(spectrograph_t *sg, float *input, float *output) {
   if (status != ippStsNoErr) {
     return false;
   }
-  float *real = &buffer[128];
-  float *imag = &buffer[200];
-  for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+  if (sg->output_mode == SPECTROGRAPH_OUTPUT_COMPLEX) {
+    memcpy(output, sg->fft_output_buffer, sizeof(Ipp32fc) * sg->n_bins);
+    return true;
+  }
+  float *real = &buffer[n_samples];
+  float *imag = &buffer[n_samples + half + 8];
+  for (unsigned int idx = 0; idx < half + 1; idx++) {
     real[idx] = sg->fft_output_buffer[idx].re;
     imag[idx] = sg->fft_output_buffer[idx].im;
   }
-  /* Compute the magnitude spectrum. */
-  vec_square_64(real, real);
-  vec_square_64(imag, imag);
-  vec_add_64(real, imag, buffer);
-  vec_sqrt_64(buffer, buffer);
-  /* Compute the power spectrum. */
-  vec_square_64(buffer, buffer);
-  vec_mul_64(buffer, sg->power_spec_coeff, buffer);
+  for (unsigned int idx = 0; idx < half; idx += 64) {
+    /* Compute the magnitude spectrum. */
+    vec_square_64(&real[idx], &real[idx]);
+    vec_square_64(&imag[idx], &imag[idx]);
+    vec_add_64(&real[idx], &imag[idx], &buffer[idx]);
+    vec_sqrt_64(&buffer[idx], &buffer[idx]);
+    /* Compute the power spectrum. */
+    vec_square_64(&buffer[idx], &buffer[idx]);
+    vec_mul_64(&buffer[idx], &sg->power_spec_coeff[idx], &buffer[idx]);
+  }
   /* Handle the final sample. */
-  buffer[64] = sqrtf(real[64] * real[64] + imag[64] * imag[64]);
-  buffer[64] *= buffer[64];
-  buffer[64] *= 0.0078125f;
+  buffer[half] = sqrtf(real[half] * real[half] + imag[half] * imag[half]);
+  buffer[half] *= buffer[half];
+  buffer[half] *= sg->power_spec_coeff[half];
   /* Compute the log power spectrum. */
-  for (unsigned int idx = 0; idx < 64 + 1; idx++) {
-    if (buffer[idx] < 1e-30) {
-      buffer[idx] = 1e-30;
+  float *spectrum = streaming ? buffer : output;
+  float *log_spectrum =
+    sg->normalization == SPECTROGRAPH_NORM_NONE ? spectrum : buffer;
+  for (unsigned int idx = 0; idx < half + 1; idx++) {
+    if (buffer[idx] < SPECTROGRAPH_POWER_FLOOR) {
+      buffer[idx] = SPECTROGRAPH_POWER_FLOOR;
     }
-    output[idx] = 10 * log10f(buffer[idx]);
+    log_spectrum[idx] = 10 * log10f(buffer[idx]);
+  }
+  if (sg->normalization != SPECTROGRAPH_NORM_NONE) {
+    /* Normalize while the log power spectrum is still in the cache. */
+    spectrograph_normalize(sg, buffer, spectrum, true);
+  }
+  if (streaming) {
+    /* Write the spectrum around the cache. */
+    spectrograph_stream(sg, buffer, output);
   }
   return true;
 }
+
+bool spectrograph_transform(spectrograph_t *sg, float *input, float *output) {
+  unsigned int n_samples = sg->n_samples;
+  float *buffer = sg->work_buffers;
+  if (sg->cache_policy == SPECTROGRAPH_CACHE_THROUGHPUT) {
+    /* Pull the input of the following frames into the cache ahead of time. */
+    float *ahead = &input[n_samples * SPECTROGRAPH_PREFETCH_FRAMES];
+    for (unsigned int idx = 0; idx < n_samples; idx += 128) {
+      vec_prefetch_128(&ahead[idx]);
+    }
+  }
+  for (unsigned int idx = 0; idx < n_samples; idx += 16) {
+    vec_copy_16(&input[idx], &buffer[idx]);
+  }
+  return spectrograph_transform_frame(sg, buffer, output);
+}
+
+int spectrograph_transform_decimated(spectrograph_t *sg, decimator_t *dec,
+                                     float *input, unsigned int n_input,
+                                     float *output, bool *gated) {
+  int n_frames = 0;
+  for (;;) {
+    /* Decimate straight into the frame buffer. */
+    unsigned int consumed;
+    sg->frame_len += decimator_process(dec, input, n_input, &consumed,
+      &sg->frame_buffer[sg->frame_len], sg->n_samples - sg->frame_len);
+    input += consumed;
+    n_input -= consumed;
+    if (sg->frame_len < sg->n_samples) {
+      break;
+    }
+    if (!spectrograph_transform_frame(sg, sg->frame_buffer, output)) {
+      return -1;
+    }
+    if (gated != NULL) {
+      gated[n_frames] = sg->gated;
+    }
+    sg->frame_len = 0;
+    output += sg->output_len;
+    n_frames++;
+  }
+  return n_frames;
+}
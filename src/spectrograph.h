@@ -31,6 +31,8 @@
 #include <math.h>
 #include <stdbool.h>
 
+#include "decimator.h"
+
 /**
  * Compute the output length of a spectrograph.
  *
@@ -40,6 +42,16 @@
  */
 #define spectrograph_output_len(n_samples) ((int)(floor((n_samples) / 2) + 1))
 
+/**
+ * Compute the output length of a spectrograph in the complex output mode.
+ *
+ * @param n_samples The number of samples per frame.
+ *
+ * @return The spectrograph output length, in floats.
+ */
+#define spectrograph_complex_output_len(n_samples) \
+  (2 * spectrograph_output_len(n_samples))
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -54,12 +66,92 @@ extern "C" {
 typedef struct spectrograph spectrograph_t;
 
 /**
- * Create a new spectrograph.
+ * The cache policy of a spectrograph controls how the input and output
+ * frames move through the cache hierarchy.
+ *
+ * SPECTROGRAPH_CACHE_LATENCY is meant for hot single frames: nothing is
+ * prefetched and the output is written through the cache so the caller can
+ * consume it immediately.
+ *
+ * SPECTROGRAPH_CACHE_THROUGHPUT is meant for streaming bulk data: the input
+ * of the frames that follow the current one is prefetched and the output is
+ * written with non-temporal stores so it does not evict the window and FFT
+ * tables from the cache. Only the part of the output between its first and
+ * last 32 byte boundaries is written with non-temporal stores, so fragments
+ * can be packed back to back.
+ */
+typedef enum spectrograph_cache_policy {
+  SPECTROGRAPH_CACHE_LATENCY,
+  SPECTROGRAPH_CACHE_THROUGHPUT
+} spectrograph_cache_policy_t;
+
+/**
+ * The normalization applied to the log power spectrum.
+ *
+ * SPECTROGRAPH_NORM_NONE leaves the log power spectrum as is.
+ *
+ * SPECTROGRAPH_NORM_RUNNING keeps an exponentially decaying mean and
+ * variance per bin, updates them with every fragment and normalizes the
+ * fragment by them (CMVN).
+ *
+ * SPECTROGRAPH_NORM_FROZEN normalizes every fragment by a fixed mean and
+ * variance per bin.
+ */
+typedef enum spectrograph_normalization {
+  SPECTROGRAPH_NORM_NONE,
+  SPECTROGRAPH_NORM_RUNNING,
+  SPECTROGRAPH_NORM_FROZEN
+} spectrograph_normalization_t;
+
+/**
+ * The output of a spectrograph.
+ *
+ * SPECTROGRAPH_OUTPUT_LOG_POWER gives the log power spectrum in dB.
+ *
+ * SPECTROGRAPH_OUTPUT_COMPLEX gives the spectrum of the windowed frame as
+ * interleaved real and imaginary parts, one pair per bin, for processing
+ * which resynthesizes the signal (see synthesizer.h). The complex spectrum
+ * is neither normalized nor written with non-temporal stores, so it stays
+ * in the cache for the synthesis. Frames below the energy gate are given a
+ * silent spectrum.
+ */
+typedef enum spectrograph_output_mode {
+  SPECTROGRAPH_OUTPUT_LOG_POWER,
+  SPECTROGRAPH_OUTPUT_COMPLEX
+} spectrograph_output_mode_t;
+
+/**
+ * The version of the normalization file format.
+ */
+#define SPECTROGRAPH_NORM_FILE_VERSION 1
+
+/**
+ * The running statistics of a spectrograph.
+ */
+typedef struct spectrograph_stats {
+  /* The number of fragments generated. */
+  unsigned long frames;
+  /* The number of fragments generated for frames below the energy gate. */
+  unsigned long gated_frames;
+} spectrograph_stats_t;
+
+/**
+ * Create a new spectrograph of 128 samples per frame.
  *
  * @return A new spectrograph.
  */
 spectrograph_t* spectrograph_create(void);
 
+/**
+ * Create a new spectrograph.
+ *
+ * @param n_samples The number of samples per frame. Must be a power of two
+ *                  between PLAN_MIN_SAMPLES and PLAN_MAX_SAMPLES.
+ *
+ * @return A new spectrograph or NULL if the size is not supported.
+ */
+spectrograph_t* spectrograph_create_size(unsigned int n_samples);
+
 /**
  * Release the resources allocated by a spectrograph.
  *
@@ -67,21 +159,212 @@ spectrograph_t* spectrograph_create(void);
  */
 void            spectrograph_destroy(spectrograph_t *sg);
 
+/**
+ * Get the number of samples per frame of a spectrograph.
+ *
+ * @param sg A spectrograph.
+ *
+ * @return The number of samples per frame.
+ */
+unsigned int    spectrograph_n_samples(spectrograph_t *sg);
+
+/**
+ * Set the cache policy of a spectrograph. New spectrographs use
+ * SPECTROGRAPH_CACHE_LATENCY.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param policy The cache policy.
+ *
+ * @return Void.
+ */
+void            spectrograph_set_cache_policy(spectrograph_t *sg,
+                                  spectrograph_cache_policy_t policy);
+
+/**
+ * Set the output of a spectrograph. New spectrographs use
+ * SPECTROGRAPH_OUTPUT_LOG_POWER.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param mode The output mode.
+ *
+ * @return Void.
+ */
+void            spectrograph_set_output_mode(spectrograph_t *sg,
+                                  spectrograph_output_mode_t mode);
+
+/**
+ * Set the energy gate of a spectrograph.
+ *
+ * Frames whose mean square energy is below the threshold skip the FFT
+ * entirely and are given the noise profile of the spectrograph instead. New
+ * spectrographs have the gate disabled.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param threshold The mean square energy of a frame below which the frame
+ *                  is gated, in squared input units. Zero disables the gate.
+ *
+ * @return Void.
+ */
+void            spectrograph_set_gate(spectrograph_t *sg, float threshold);
+
+/**
+ * Set the noise profile given to the frames below the energy gate.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param spectrum A pointer to an array of floats of length
+ *                 spectrograph_output_len(n_samples) holding a log power
+ *                 spectrum, or NULL to use the floor of the log power
+ *                 spectrum (-300dB).
+ *
+ * @return Void.
+ */
+void            spectrograph_set_noise_profile(spectrograph_t *sg,
+                                               float *spectrum);
+
+/**
+ * Set the normalization of a spectrograph. New spectrographs do not
+ * normalize.
+ *
+ * Switching to SPECTROGRAPH_NORM_RUNNING restarts the statistics from the
+ * next fragment. Switching to SPECTROGRAPH_NORM_FROZEN freezes the current
+ * statistics. Fragments below the energy gate are normalized but do not
+ * update the statistics.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param mode The normalization.
+ *
+ * @param decay The weight of the statistics of the previous fragments when
+ *              they are updated, between 0 and 1. Only used by
+ *              SPECTROGRAPH_NORM_RUNNING.
+ *
+ * @return Void.
+ */
+void            spectrograph_set_normalization(spectrograph_t *sg,
+                                  spectrograph_normalization_t mode,
+                                  float decay);
+
+/**
+ * Load the per bin mean and variance saved by
+ * spectrograph_save_normalization and freeze them.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param path The path of the file.
+ *
+ * @return True on success or false if the file is missing, truncated or of
+ *         a different version.
+ */
+bool            spectrograph_load_normalization(spectrograph_t *sg,
+                                                const char *path);
+
+/**
+ * Save the current per bin mean and variance of a spectrograph.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param path The path of the file.
+ *
+ * @return True on success.
+ */
+bool            spectrograph_save_normalization(spectrograph_t *sg,
+                                                const char *path);
+
+/**
+ * Check whether the last spectrogram fragment was generated for a frame
+ * below the energy gate. spectrograph_transform_decimated reports every
+ * fragment it generates through its gated array instead.
+ *
+ * @param sg A spectrograph.
+ *
+ * @return True if the last fragment was gated.
+ */
+bool            spectrograph_gated(spectrograph_t *sg);
+
+/**
+ * Get the running statistics of a spectrograph.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param stats The destination for the statistics.
+ *
+ * @return Void.
+ */
+void            spectrograph_get_stats(spectrograph_t *sg,
+                                       spectrograph_stats_t *stats);
+
+/**
+ * Reset the running statistics of a spectrograph.
+ *
+ * @param sg A spectrograph.
+ *
+ * @return Void.
+ */
+void            spectrograph_reset_stats(spectrograph_t *sg);
+
 /**
  * Generate a spectrogram fragment for one frame of the input signal.
  *
  * @param sg A spectrograph.
  *
- * @param input A pointer to an array of floats of length 128. 
+ * @param input A pointer to an array of floats of length n_samples. When the
+ *              throughput cache policy is used the input of the frames
+ *              that follow is prefetched, so consecutive frames should be
+ *              laid out contiguously.
  *
  * @param output A pointer to an array of floats which will store the resulting
- *               spectrogram fragment. The output will be of length 64 + 1.
+ *               spectrogram fragment. The output will be of length
+ *               spectrograph_output_len(n_samples), or
+ *               spectrograph_complex_output_len(n_samples) in the complex
+ *               output mode.
  *
  * @return Void.
  */
 bool             spectrograph_transform(spectrograph_t *sg, float *input,
                                         float *output);
 
+/**
+ * Generate the spectrogram fragments for a block of an input signal which
+ * is sampled at a multiple of the analysis rate.
+ *
+ * The block is decimated and framed in a single streaming pass: the
+ * decimator writes its output straight into the frame buffer of the
+ * spectrograph and a fragment is generated every time n_samples decimated
+ * samples have been collected. Samples which do not complete a frame are
+ * kept until the next call.
+ *
+ * @param sg A spectrograph.
+ *
+ * @param dec A decimator. The same decimator should be used for every block
+ *            of a signal.
+ *
+ * @param input A pointer to an array of floats of length n_input.
+ *
+ * @param n_input The number of input samples.
+ *
+ * @param output A pointer to an array of floats which will store the
+ *               resulting spectrogram fragments back to back. The output
+ *               must have room for n_input / (n_samples * factor) + 1
+ *               fragments of the output length of the spectrograph.
+ *
+ * @param gated A pointer to an array of bools with room for as many entries
+ *              as the output has fragments, which will store whether each
+ *              fragment was generated for a frame below the energy gate, or
+ *              NULL.
+ *
+ * @return The number of fragments generated or -1 on failure.
+ */
+int              spectrograph_transform_decimated(spectrograph_t *sg,
+                                                  decimator_t *dec,
+                                                  float *input,
+                                                  unsigned int n_input,
+                                                  float *output,
+                                                  bool *gated);
+
 #ifdef __cplusplus
 }
 #endif
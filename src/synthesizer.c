@@ -0,0 +1,189 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file synthesizer.c
+ *  @brief Implements the synthesizer interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+/* C Run-time */
+#include <stdlib.h>
+#include <string.h>
+
+/* Intel Integrated Performance Primitives */
+#include "ipp.h"
+
+/* Spectrograph Run-time */
+#include "plan.h"
+#include "synthesizer.h"
+#include "vector.h"
+
+/* The smallest sum of squared windows a sample is divided by. Samples below
+   it, at the very start of a signal, are silent. */
+#define SYNTHESIZER_WEIGHT_FLOOR 1e-6f
+
+typedef struct synthesizer {
+  plan_t             *plan;
+  unsigned int        n_samples;
+  unsigned int        hop;
+  Ipp32fc            *io_buffers;
+  Ipp8u              *fft_buffers;
+  float              *work_buffers;
+  /* Constants */
+  float              *window;
+  float              *window_sq;
+  /* Overlap-add */
+  float              *frame;
+  float              *overlap;
+  float              *weights;
+  /* FFT */
+  Ipp32fc            *fft_input_buffer;
+  Ipp32fc            *fft_output_buffer;
+  IppsFFTSpec_C_32fc *fft_spec;
+  Ipp8u              *fft_work_buffer;
+} synthesizer_t;
+
+synthesizer_t* synthesizer_create(unsigned int n_samples, unsigned int hop) {
+  if (hop == 0 || hop > n_samples) {
+    return NULL;
+  }
+  synthesizer_t *syn = (synthesizer_t*)malloc(sizeof(synthesizer_t));
+  if (syn == NULL) {
+    return NULL;
+  }
+  /* Share the FFT specification and the window with the spectrographs. */
+  plan_t *plan = plan_acquire(n_samples, PLAN_WINDOW_HANN);
+  if (plan == NULL) {
+    free(syn);
+    return NULL;
+  }
+  syn->plan = plan;
+  syn->n_samples = n_samples;
+  syn->hop = hop;
+  syn->window = plan->window;
+  syn->fft_spec = plan->fft_spec;
+  /* Initialize the FFT run-time. */
+  Ipp32fc *io_buffers = ippsMalloc_32fc(n_samples * 2);
+  if (io_buffers == NULL) {
+    plan_release(plan);
+    free(syn);
+    return NULL;
+  }
+  syn->io_buffers = io_buffers;
+  syn->fft_input_buffer = io_buffers;
+  syn->fft_output_buffer = &io_buffers[n_samples];
+  Ipp8u *fft_buffers = ippsMalloc_8u(plan->fft_work_buffer_len);
+  if (fft_buffers == NULL) {
+    ippFree(io_buffers);
+    plan_release(plan);
+    free(syn);
+    return NULL;
+  }
+  syn->fft_buffers = fft_buffers;
+  syn->fft_work_buffer = fft_buffers;
+  /* Initialize the overlap-add run-time. */
+  unsigned int work_buffer_size = sizeof(float) * n_samples * 4;
+  float *work_buffers = (float*)aligned_alloc(32, work_buffer_size);
+  if (work_buffers == NULL) {
+    ippFree(io_buffers);
+    ippFree(fft_buffers);
+    plan_release(plan);
+    free(syn);
+    return NULL;
+  }
+  syn->work_buffers = work_buffers;
+  syn->window_sq = work_buffers;
+  syn->frame = &work_buffers[n_samples];
+  syn->overlap = &work_buffers[n_samples * 2];
+  syn->weights = &work_buffers[n_samples * 3];
+  for (unsigned int idx = 0; idx < n_samples; idx += 64) {
+    vec_square_64(&syn->window[idx], &syn->window_sq[idx]);
+  }
+  memset(syn->overlap, 0, sizeof(float) * n_samples * 2);
+  return syn;
+}
+
+void synthesizer_destroy(synthesizer_t *syn) {
+  ippFree(syn->io_buffers);
+  ippFree(syn->fft_buffers);
+  free(syn->work_buffers);
+  plan_release(syn->plan);
+  free(syn);
+}
+
+/**
+ * Give the first samples of the overlap-add buffers, divided by the sum of
+ * the squared windows.
+ */
+static void synthesizer_emit(synthesizer_t *syn, float *output,
+                             unsigned int len) {
+  for (unsigned int idx = 0; idx < len; idx++) {
+    output[idx] = syn->weights[idx] < SYNTHESIZER_WEIGHT_FLOOR ?
+      0 : syn->overlap[idx] / syn->weights[idx];
+  }
+}
+
+bool synthesizer_process(synthesizer_t *syn, float *spectrum, float *gains,
+                         float *output) {
+  unsigned int n_samples = syn->n_samples;
+  unsigned int half = n_samples / 2;
+  Ipp32fc *bins = (Ipp32fc*)spectrum;
+  /* Rebuild the full spectrum from its Hermitian half, folding the gains
+     and the scaling of the inverse FFT in. */
+  for (unsigned int idx = 0; idx < half + 1; idx++) {
+    float scale = (gains != NULL ? gains[idx] : 1) / n_samples;
+    syn->fft_input_buffer[idx].re = bins[idx].re * scale;
+    syn->fft_input_buffer[idx].im = bins[idx].im * scale;
+  }
+  for (unsigned int idx = 1; idx < half; idx++) {
+    syn->fft_input_buffer[n_samples - idx].re =
+      syn->fft_input_buffer[idx].re;
+    syn->fft_input_buffer[n_samples - idx].im =
+      -syn->fft_input_buffer[idx].im;
+  }
+  IppStatus status = ippsFFTInv_CToC_32fc(syn->fft_input_buffer,
+    syn->fft_output_buffer, syn->fft_spec, syn->fft_work_buffer);
+  if (status != ippStsNoErr) {
+    return false;
+  }
+  for (unsigned int idx = 0; idx < n_samples; idx++) {
+    syn->frame[idx] = syn->fft_output_buffer[idx].re;
+  }
+  /* Window the frame again and add it to the frames before it. */
+  for (unsigned int idx = 0; idx < n_samples; idx += 64) {
+    vec_mul_64(&syn->window[idx], &syn->frame[idx], &syn->frame[idx]);
+    vec_add_64(&syn->overlap[idx], &syn->frame[idx], &syn->overlap[idx]);
+    vec_add_64(&syn->weights[idx], &syn->window_sq[idx], &syn->weights[idx]);
+  }
+  synthesizer_emit(syn, output, syn->hop);
+  /* Discard the complete samples. */
+  unsigned int len = n_samples - syn->hop;
+  memmove(syn->overlap, &syn->overlap[syn->hop], sizeof(float) * len);
+  memmove(syn->weights, &syn->weights[syn->hop], sizeof(float) * len);
+  memset(&syn->overlap[len], 0, sizeof(float) * syn->hop);
+  memset(&syn->weights[len], 0, sizeof(float) * syn->hop);
+  return true;
+}
+
+void synthesizer_flush(synthesizer_t *syn, float *output) {
+  synthesizer_emit(syn, output, syn->n_samples - syn->hop);
+  memset(syn->overlap, 0, sizeof(float) * syn->n_samples * 2);
+}
@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file synthesizer.h
+ *  @brief Public functions, macros and type definitions used for
+ *         resynthesizing signals from their spectrums.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#ifndef SYNTHESIZER_H
+#define SYNTHESIZER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A synthesizer is the inverse of a spectrograph in the complex output
+ * mode: it turns the spectrums of consecutive frames back into a signal by
+ * weighted overlap-add.
+ *
+ * Each spectrum is scaled by a gain per bin, inverse transformed, windowed
+ * again by the analysis window and added to the frames before it. The sum
+ * is divided by the sum of the squared windows which overlap each sample,
+ * so a signal analyzed and resynthesized with unity gains is reconstructed
+ * exactly.
+ *
+ * A synthesizer acquires the same plan as a spectrograph of the same frame
+ * size, so the FFT specification and the window are shared, and it does
+ * not allocate once created.
+ */
+typedef struct synthesizer synthesizer_t;
+
+/**
+ * Create a new synthesizer.
+ *
+ * @param n_samples The number of samples per frame. Must be a power of two
+ *                  between PLAN_MIN_SAMPLES and PLAN_MAX_SAMPLES.
+ *
+ * @param hop The number of samples between the frames, between 1 and
+ *            n_samples.
+ *
+ * @return A new synthesizer or NULL on failure.
+ */
+synthesizer_t* synthesizer_create(unsigned int n_samples, unsigned int hop);
+
+/**
+ * Release the resources allocated by a synthesizer.
+ *
+ * @return Void.
+ */
+void           synthesizer_destroy(synthesizer_t *syn);
+
+/**
+ * Add the next frame to the synthesized signal.
+ *
+ * The frames are expected hop samples apart, starting at the first sample
+ * of the signal. The samples which no later frame overlaps are complete, so
+ * every call gives the next hop samples of the signal.
+ *
+ * @param syn A synthesizer.
+ *
+ * @param spectrum A pointer to an array of floats of length
+ *                 spectrograph_complex_output_len(n_samples) as generated
+ *                 by a spectrograph in the complex output mode.
+ *
+ * @param gains A pointer to an array of floats of length
+ *              spectrograph_output_len(n_samples) holding the gain of each
+ *              bin, or NULL for unity gains.
+ *
+ * @param output A pointer to an array of floats of length hop which will
+ *               store the next samples of the signal.
+ *
+ * @return True on success.
+ */
+bool           synthesizer_process(synthesizer_t *syn, float *spectrum,
+                                   float *gains, float *output);
+
+/**
+ * Give the samples which are still waiting for later frames, at the end of
+ * a signal, and start over.
+ *
+ * @param syn A synthesizer.
+ *
+ * @param output A pointer to an array of floats of length n_samples - hop
+ *               which will store the last samples of the signal.
+ *
+ * @return Void.
+ */
+void           synthesizer_flush(synthesizer_t *syn, float *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNTHESIZER_H */
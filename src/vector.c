@@ -61,7 +61,8 @@ inline void vec_add_64(float *a, float *b, float *c) {
     "vmovaps 224(%0), %%ymm14\n\t"
     "vmovaps 224(%1), %%ymm15\n\t"
     "vaddps %%ymm14, %%ymm15, %%ymm15\n\t"
-    "vmovaps %%ymm15, 224(%2)"
+    "vmovaps %%ymm15, 224(%2)\n\t"
+    "vzeroupper"
     : /* outputs */
     : "g"(a), "g"(b), "g"(c)
     :"ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
@@ -70,31 +71,87 @@ inline void vec_add_64(float *a, float *b, float *c) {
   );
 }
 
+inline void vec_cmvn_64(float *a, float *b, float *mean, float *var,
+                        float rate) {
+  float keep = 1.0f - rate;
+  float epsilon = VEC_CMVN_EPSILON;
+  unsigned int n = 64;
+  __asm__ __volatile__(
+    "vbroadcastss %5, %%ymm5\n\t"
+    "vbroadcastss %6, %%ymm6\n\t"
+    "vbroadcastss %7, %%ymm7\n\t"
+    "1:\n\t"
+    "vmovaps (%0), %%ymm0\n\t"
+    "vmovaps (%2), %%ymm1\n\t"
+    "vsubps %%ymm1, %%ymm0, %%ymm2\n\t"
+    "vmulps %%ymm5, %%ymm2, %%ymm3\n\t"
+    "vaddps %%ymm3, %%ymm1, %%ymm1\n\t"
+    "vmovaps %%ymm1, (%2)\n\t"
+    "vmulps %%ymm2, %%ymm3, %%ymm3\n\t"
+    "vaddps (%3), %%ymm3, %%ymm3\n\t"
+    "vmulps %%ymm6, %%ymm3, %%ymm3\n\t"
+    "vmovaps %%ymm3, (%3)\n\t"
+    "vsubps %%ymm1, %%ymm0, %%ymm0\n\t"
+    "vaddps %%ymm7, %%ymm3, %%ymm3\n\t"
+    "vsqrtps %%ymm3, %%ymm3\n\t"
+    "vdivps %%ymm3, %%ymm0, %%ymm0\n\t"
+    "vmovups %%ymm0, (%1)\n\t"
+    "add $32, %0\n\t"
+    "add $32, %1\n\t"
+    "add $32, %2\n\t"
+    "add $32, %3\n\t"
+    "sub $8, %4\n\t"
+    "jnz 1b\n\t"
+    "vzeroupper"
+    : "+r"(a), "+r"(b), "+r"(mean), "+r"(var), "+r"(n)
+    : "m"(rate), "m"(keep), "m"(epsilon)
+    :"ymm0", "ymm1", "ymm2", "ymm3", "ymm5", "ymm6", "ymm7", "cc", "memory"
+  );
+}
+
 inline void vec_copy_16(float *a, float *b) {
   __asm__(
-    "prefetchnta 64(%0)\n\t"
-    "movq (%0), %%mm0\n\t"
-    "movq 8(%0), %%mm1\n\t"
-    "movq 16(%0), %%mm2\n\t"
-    "movq 24(%0), %%mm3\n\t"
-    "movq 32(%0), %%mm4\n\t"
-    "movq 40(%0), %%mm5\n\t"
-    "movq 48(%0), %%mm6\n\t"
-    "movq 56(%0), %%mm7\n\t"
-    "movntq %%mm0, (%1)\n\t"
-    "movntq %%mm1, 8(%1)\n\t"
-    "movntq %%mm2, 16(%1)\n\t"
-    "movntq %%mm3, 24(%1)\n\t"
-    "movntq %%mm4, 32(%1)\n\t"
-    "movntq %%mm5, 40(%1)\n\t"
-    "movntq %%mm6, 48(%1)\n\t"
-    "movntq %%mm7, 56(%1)"
+    "vmovups (%0), %%ymm0\n\t"
+    "vmovups 32(%0), %%ymm1\n\t"
+    "vmovaps %%ymm0, (%1)\n\t"
+    "vmovaps %%ymm1, 32(%1)\n\t"
+    "vzeroupper"
     : /* outputs */
     : "g"(a), "g"(b)
-    :"mm0", "mm1", "mm2", "mm3", "mm4", "mm5", "mm6", "mm7"
+    :"ymm0", "ymm1"
   );
 }
 
+inline float vec_dot(float *a, float *b, unsigned int n) {
+  float result;
+  __asm__(
+    "vxorps %%ymm0, %%ymm0, %%ymm0\n\t"
+    "vxorps %%ymm1, %%ymm1, %%ymm1\n\t"
+    "1:\n\t"
+    "vmovups (%1), %%ymm2\n\t"
+    "vmovups 32(%1), %%ymm3\n\t"
+    "vmulps (%2), %%ymm2, %%ymm2\n\t"
+    "vmulps 32(%2), %%ymm3, %%ymm3\n\t"
+    "vaddps %%ymm2, %%ymm0, %%ymm0\n\t"
+    "vaddps %%ymm3, %%ymm1, %%ymm1\n\t"
+    "add $64, %1\n\t"
+    "add $64, %2\n\t"
+    "sub $16, %3\n\t"
+    "jnz 1b\n\t"
+    "vaddps %%ymm1, %%ymm0, %%ymm0\n\t"
+    "vextractf128 $1, %%ymm0, %%xmm1\n\t"
+    "vaddps %%xmm1, %%xmm0, %%xmm0\n\t"
+    "vhaddps %%xmm0, %%xmm0, %%xmm0\n\t"
+    "vhaddps %%xmm0, %%xmm0, %%xmm0\n\t"
+    "vmovss %%xmm0, %0\n\t"
+    "vzeroupper"
+    : "=m"(result), "+r"(a), "+r"(b), "+r"(n)
+    : /* inputs */
+    :"ymm0", "ymm1", "ymm2", "ymm3", "cc", "memory"
+  );
+  return result;
+}
+
 inline void vec_mul_64(float *a, float *b, float *c) {
   __asm__(
     "vmovaps (%0), %%ymm0\n\t"
@@ -128,7 +185,8 @@ inline void vec_mul_64(float *a, float *b, float *c) {
     "vmovaps 224(%0), %%ymm14\n\t"
     "vmovaps 224(%1), %%ymm15\n\t"
     "vmulps %%ymm14, %%ymm15, %%ymm15\n\t"
-    "vmovaps %%ymm15, 224(%2)"
+    "vmovaps %%ymm15, 224(%2)\n\t"
+    "vzeroupper"
     : /* outputs */
     : "g"(a), "g"(b), "g"(c)
     :"ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
@@ -137,6 +195,64 @@ inline void vec_mul_64(float *a, float *b, float *c) {
   );
 }
 
+inline void vec_normalize_64(float *a, float *b, float *mean,
+                             float *scale) {
+  __asm__(
+    "vmovaps (%0), %%ymm0\n\t"
+    "vsubps (%2), %%ymm0, %%ymm0\n\t"
+    "vmulps (%3), %%ymm0, %%ymm0\n\t"
+    "vmovups %%ymm0, (%1)\n\t"
+    "vmovaps 32(%0), %%ymm1\n\t"
+    "vsubps 32(%2), %%ymm1, %%ymm1\n\t"
+    "vmulps 32(%3), %%ymm1, %%ymm1\n\t"
+    "vmovups %%ymm1, 32(%1)\n\t"
+    "vmovaps 64(%0), %%ymm2\n\t"
+    "vsubps 64(%2), %%ymm2, %%ymm2\n\t"
+    "vmulps 64(%3), %%ymm2, %%ymm2\n\t"
+    "vmovups %%ymm2, 64(%1)\n\t"
+    "vmovaps 96(%0), %%ymm3\n\t"
+    "vsubps 96(%2), %%ymm3, %%ymm3\n\t"
+    "vmulps 96(%3), %%ymm3, %%ymm3\n\t"
+    "vmovups %%ymm3, 96(%1)\n\t"
+    "vmovaps 128(%0), %%ymm4\n\t"
+    "vsubps 128(%2), %%ymm4, %%ymm4\n\t"
+    "vmulps 128(%3), %%ymm4, %%ymm4\n\t"
+    "vmovups %%ymm4, 128(%1)\n\t"
+    "vmovaps 160(%0), %%ymm5\n\t"
+    "vsubps 160(%2), %%ymm5, %%ymm5\n\t"
+    "vmulps 160(%3), %%ymm5, %%ymm5\n\t"
+    "vmovups %%ymm5, 160(%1)\n\t"
+    "vmovaps 192(%0), %%ymm6\n\t"
+    "vsubps 192(%2), %%ymm6, %%ymm6\n\t"
+    "vmulps 192(%3), %%ymm6, %%ymm6\n\t"
+    "vmovups %%ymm6, 192(%1)\n\t"
+    "vmovaps 224(%0), %%ymm7\n\t"
+    "vsubps 224(%2), %%ymm7, %%ymm7\n\t"
+    "vmulps 224(%3), %%ymm7, %%ymm7\n\t"
+    "vmovups %%ymm7, 224(%1)\n\t"
+    "vzeroupper"
+    : /* outputs */
+    : "r"(a), "r"(b), "r"(mean), "r"(scale)
+    :"ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
+     "memory"
+  );
+}
+
+inline void vec_prefetch_128(float *a) {
+  __asm__(
+    "prefetcht0 (%0)\n\t"
+    "prefetcht0 64(%0)\n\t"
+    "prefetcht0 128(%0)\n\t"
+    "prefetcht0 192(%0)\n\t"
+    "prefetcht0 256(%0)\n\t"
+    "prefetcht0 320(%0)\n\t"
+    "prefetcht0 384(%0)\n\t"
+    "prefetcht0 448(%0)"
+    : /* outputs */
+    : "g"(a)
+  );
+}
+
 inline void vec_sqrt_64(float *a, float *b) {
   __asm__(
     "vmovaps (%0), %%ymm0\n\t"
@@ -162,7 +278,8 @@ inline void vec_sqrt_64(float *a, float *b) {
     "vmovaps %%ymm13, 192(%1)\n\t"
     "vmovaps 224(%0), %%ymm14\n\t"
     "vsqrtps %%ymm14, %%ymm15\n\t"
-    "vmovaps %%ymm15, 224(%1)"
+    "vmovaps %%ymm15, 224(%1)\n\t"
+    "vzeroupper"
     : /* outputs */
     : "g"(a), "g"(b)
     :"ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
@@ -171,6 +288,23 @@ inline void vec_sqrt_64(float *a, float *b) {
   );
 }
 
+inline void vec_stream(float *a, float *b, unsigned int n) {
+  __asm__ __volatile__(
+    "1:\n\t"
+    "vmovups (%0), %%ymm0\n\t"
+    "vmovntps %%ymm0, (%1)\n\t"
+    "add $32, %0\n\t"
+    "add $32, %1\n\t"
+    "sub $8, %2\n\t"
+    "jnz 1b\n\t"
+    "sfence\n\t"
+    "vzeroupper"
+    : "+r"(a), "+r"(b), "+r"(n)
+    : /* inputs */
+    :"ymm0", "cc", "memory"
+  );
+}
+
 inline void vec_square_64(float *a, float *b) {
   __asm__(
     "vmovaps (%0), %%ymm0\n\t"
@@ -204,7 +338,8 @@ inline void vec_square_64(float *a, float *b) {
     "vmovaps 224(%0), %%ymm14\n\t"
     "vmovaps 224(%0), %%ymm15\n\t"
     "vmulps %%ymm14, %%ymm15, %%ymm15\n\t"
-    "vmovaps %%ymm15, 224(%1)"
+    "vmovaps %%ymm15, 224(%1)\n\t"
+    "vzeroupper"
     : /* outputs */
     : "g"(a), "g"(b)
     :"ymm0", "ymm1", "ymm2", "ymm3", "ymm4", "ymm5", "ymm6", "ymm7",
@@ -29,6 +29,11 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+/**
+ * The constant added to the variance before normalizing by it.
+ */
+#define VEC_CMVN_EPSILON 1e-6f
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -45,15 +50,41 @@ extern "C" {
 void vec_add_64(float *a, float *b, float *c);
 
 /**
- * Copy a vector of 16 floats.
+ * Update the exponentially decaying mean and variance of a vector of 64
+ * floats and normalize the vector by them (CMVN).
  *
  * @param a The source.
+ * @param b The destination for (a - mean) / sqrt(var + VEC_CMVN_EPSILON).
+ *          The destination does not have to be aligned.
+ * @param mean The running mean, updated in place.
+ * @param var The running variance, updated in place.
+ * @param rate The weight of the source in the update, 1 - decay.
+ *
+ * @return Void
+ */
+void vec_cmvn_64(float *a, float *b, float *mean, float *var, float rate);
+
+/**
+ * Copy a vector of 16 floats.
+ *
+ * @param a The source. The source does not have to be aligned.
  * @param b The destination.
  *
  * @return Void
  */
 void vec_copy_16(float *a, float *b);
 
+/**
+ * Compute the dot product of two vectors of floats.
+ *
+ * @param a The first term. The first term does not have to be aligned.
+ * @param b The second term.
+ * @param n The length of both vectors. Must be a non-zero multiple of 16.
+ *
+ * @return The dot product of a and b.
+ */
+float vec_dot(float *a, float *b, unsigned int n);
+
 /**
  * Multiply two vectors of 64 floats.
  *
@@ -65,6 +96,30 @@ void vec_copy_16(float *a, float *b);
  */
 void vec_mul_64(float *a, float *b, float *c);
 
+/**
+ * Normalize a vector of 64 floats by a fixed mean and scale.
+ *
+ * @param a The source.
+ * @param b The destination for (a - mean) * scale. The destination does not
+ *          have to be aligned.
+ * @param mean The mean.
+ * @param scale The scale.
+ *
+ * @return Void
+ */
+void vec_normalize_64(float *a, float *b, float *mean, float *scale);
+
+/**
+ * Prefetch a vector of 128 floats into all levels of the cache.
+ *
+ * Prefetching never faults, so the address does not have to be valid.
+ *
+ * @param a The vector to prefetch.
+ *
+ * @return Void
+ */
+void vec_prefetch_128(float *a);
+
 /**
  * Compute the square root of each float in a vector of 64 floats.
  *
@@ -73,6 +128,20 @@ void vec_mul_64(float *a, float *b, float *c);
  */
 void vec_sqrt_64(float *a, float *b);
 
+/**
+ * Copy a vector of floats using non-temporal stores.
+ *
+ * The destination is written around the cache so it does not evict data
+ * which is still in use. The stores are fenced before returning.
+ *
+ * @param a The source. The source does not have to be aligned.
+ * @param b The destination.
+ * @param n The length of both vectors. Must be a non-zero multiple of 8.
+ *
+ * @return Void
+ */
+void vec_stream(float *a, float *b, unsigned int n);
+
 /**
  * Compute the square of each float in a vector of 64 floats.
  *
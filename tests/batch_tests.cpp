@@ -0,0 +1,204 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file batch_tests.cpp
+ *  @brief Tests the batch interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/batch.h"
+#include "../src/spectrograph.h"
+
+/* Generate a 1Khz sine wave sampled @ 8Khz. */
+#define SINE_WAVE_GEN(N) ((short)(16384 * sin((2 * M_PI * N * 1000) / 8000)))
+
+/* The number of files of the batch. */
+#define N_FILES 6
+
+TEST(batch_tests, batch_invalid_test) {
+  const char *paths[] = { "/nonexistent" };
+  ASSERT_EQ(batch_run(paths, paths, 1, 0, 128, 64, 0, NULL), -1);
+  ASSERT_EQ(batch_run(paths, paths, 1, 1, 100, 64, 0, NULL), -1);
+  ASSERT_EQ(batch_run(paths, paths, 1, 1, 128, 0, 0, NULL), -1);
+}
+
+TEST(batch_tests, batch_run_test) {
+  char dir[] = "/tmp/batch_tests.XXXXXX";
+  ASSERT_FALSE(mkdtemp(dir) == NULL);
+  char input_names[N_FILES][64], output_names[N_FILES][64];
+  const char *input_paths[N_FILES], *output_paths[N_FILES];
+  /* The lengths of the files. The second is shorter than a frame and the
+     last one does not exist. */
+  unsigned int lens[N_FILES] = { 4000, 100, 128, 8192, 1000, 0 };
+  short *signal = (short*)malloc(sizeof(short) * 8192);
+  ASSERT_FALSE(signal == NULL);
+  for (unsigned int idx = 0; idx < 8192; idx++) {
+    signal[idx] = SINE_WAVE_GEN(idx) / (short)(1 + idx % 3);
+  }
+  for (unsigned int idx = 0; idx < N_FILES; idx++) {
+    snprintf(input_names[idx], 64, "%s/%u.pcm", dir, idx);
+    snprintf(output_names[idx], 64, "%s/%u.spec", dir, idx);
+    input_paths[idx] = input_names[idx];
+    output_paths[idx] = output_names[idx];
+    if (lens[idx] > 0) {
+      FILE *file = fopen(input_paths[idx], "wb");
+      ASSERT_FALSE(file == NULL);
+      ASSERT_EQ(fwrite(signal, sizeof(short), lens[idx], file), lens[idx]);
+      fclose(file);
+    }
+  }
+  batch_status_t status[N_FILES];
+  ASSERT_EQ(batch_run(input_paths, output_paths, N_FILES, 3, 128, 64, 0,
+    status), N_FILES - 1);
+  ASSERT_EQ(status[N_FILES - 1], BATCH_FAILED);
+  /* Every spectrogram matches the one of a single spectrograph. */
+  spectrograph_t *spectrograph = spectrograph_create();
+  ASSERT_FALSE(spectrograph == NULL);
+  float frame[128], expected[64 + 1], fragment[64 + 1];
+  for (unsigned int idx = 0; idx < N_FILES - 1; idx++) {
+    ASSERT_EQ(status[idx], BATCH_DONE);
+    unsigned int n_frames = lens[idx] >= 128 ? (lens[idx] - 128) / 64 + 1 : 0;
+    FILE *file = fopen(output_paths[idx], "rb");
+    ASSERT_FALSE(file == NULL);
+    for (unsigned int jdx = 0; jdx < n_frames; jdx++) {
+      for (unsigned int kdx = 0; kdx < 128; kdx++) {
+        frame[kdx] = signal[jdx * 64 + kdx];
+      }
+      spectrograph_transform(spectrograph, frame, expected);
+      ASSERT_EQ(fread(fragment, sizeof(float), 64 + 1, file), 64u + 1);
+      ASSERT_EQ(memcmp(fragment, expected, sizeof(expected)), 0);
+    }
+    /* Nothing follows the last fragment. */
+    ASSERT_EQ(fread(fragment, sizeof(float), 1, file), 0u);
+    fclose(file);
+  }
+  spectrograph_destroy(spectrograph);
+  for (unsigned int idx = 0; idx < N_FILES; idx++) {
+    unlink(input_paths[idx]);
+    unlink(output_paths[idx]);
+  }
+  rmdir(dir);
+  free(signal);
+}
+
+/**
+ * Write a file of silence.
+ */
+static bool write_silence(const char *path, unsigned int len) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  short sample = 0;
+  for (unsigned int idx = 0; idx < len; idx++) {
+    fwrite(&sample, sizeof(short), 1, file);
+  }
+  return fclose(file) == 0;
+}
+
+/**
+ * Count the files of a directory, to find temporary files left behind.
+ */
+static unsigned int count_entries(const char *path) {
+  DIR *dir = opendir(path);
+  unsigned int n_entries = 0;
+  if (dir != NULL) {
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      if (entry->d_name[0] != '.') {
+        n_entries++;
+      }
+    }
+    closedir(dir);
+  }
+  return n_entries;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+TEST(batch_tests, batch_crash_test) {
+  char dir[] = "/tmp/batch_tests.XXXXXX";
+  ASSERT_FALSE(mkdtemp(dir) == NULL);
+  char input_names[3][64], output_names[3][64];
+  const char *input_paths[3], *output_paths[3];
+  for (unsigned int idx = 0; idx < 3; idx++) {
+    snprintf(input_names[idx], 64, "%s/%u.pcm", dir, idx);
+    snprintf(output_names[idx], 64, "%s/%u.spec", dir, idx);
+    input_paths[idx] = input_names[idx];
+    output_paths[idx] = output_names[idx];
+  }
+  /* A fifo without a writer blocks the worker which opens it until the
+     deadline kills the worker. */
+  ASSERT_TRUE(write_silence(input_paths[0], 1024));
+  ASSERT_EQ(mkfifo(input_paths[1], 0600), 0);
+  ASSERT_TRUE(write_silence(input_paths[2], 1024));
+  /* The output of an earlier run does not survive a failed file. */
+  ASSERT_TRUE(write_silence(output_paths[1], 1024));
+  /* The file is given up on once every attempt was killed, and the
+     replacement workers finish the rest of the batch. */
+  batch_status_t status[3];
+  ASSERT_EQ(batch_run(input_paths, output_paths, 3, 1, 128, 64, 1, status),
+    2);
+  ASSERT_EQ(status[0], BATCH_DONE);
+  ASSERT_EQ(status[1], BATCH_FAILED);
+  ASSERT_EQ(status[2], BATCH_DONE);
+  struct stat st;
+  ASSERT_NE(stat(output_paths[1], &st), 0);
+  ASSERT_EQ(count_entries(dir), 5u);
+  /* A file which kills its first worker is handed out again: replace the
+     fifo with a regular file while the first worker is blocked on it. */
+  std::thread replace([&input_paths]() {
+    usleep(300000);
+    unlink(input_paths[1]);
+    write_silence(input_paths[1], 1024);
+  });
+  double start = now();
+  int n_done = batch_run(&input_paths[1], &output_paths[1], 1, 1, 128, 64,
+    1, status);
+  double elapsed = now() - start;
+  replace.join();
+  ASSERT_EQ(n_done, 1);
+  ASSERT_EQ(status[0], BATCH_DONE);
+  /* The first attempt ran into the deadline. */
+  ASSERT_GE(elapsed, 1.0);
+  ASSERT_EQ(stat(output_paths[1], &st), 0);
+  ASSERT_EQ(count_entries(dir), 6u);
+  for (unsigned int idx = 0; idx < 3; idx++) {
+    unlink(input_paths[idx]);
+    unlink(output_paths[idx]);
+  }
+  rmdir(dir);
+}
@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file decimator_tests.cpp
+ *  @brief Tests the decimator interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "../src/decimator.h"
+
+TEST(decimator_tests, decimator_factor_test) {
+  ASSERT_TRUE(decimator_create(DECIMATOR_MIN_FACTOR - 1) == NULL);
+  ASSERT_TRUE(decimator_create(DECIMATOR_MAX_FACTOR + 1) == NULL);
+  for (unsigned int factor = DECIMATOR_MIN_FACTOR;
+       factor <= DECIMATOR_MAX_FACTOR; factor++) {
+    decimator_t *decimator = decimator_create(factor);
+    ASSERT_FALSE(decimator == NULL);
+    ASSERT_EQ(decimator_factor(decimator), factor);
+    decimator_destroy(decimator);
+  }
+}
+
+TEST(decimator_tests, decimator_dc_test) {
+  float *memory = (float*)malloc(sizeof(float) * 4096 * 2);
+  if (memory) {
+    float *input = memory;
+    float *output = &memory[4096];
+    for (unsigned int idx = 0; idx < 4096; idx++) {
+      input[idx] = 1.0;
+    }
+    decimator_t *decimator = decimator_create(6);
+    ASSERT_FALSE(decimator == NULL);
+    unsigned int consumed;
+    unsigned int produced = decimator_process(decimator, input, 4096,
+      &consumed, output, 4096);
+    ASSERT_EQ(consumed, 4096u);
+    ASSERT_EQ(produced, 4096u / 6 + 1);
+    /* Once the filter has settled a constant signal is passed unchanged. */
+    for (unsigned int idx = decimator_taps_len(6) / 6; idx < produced;
+         idx++) {
+      ASSERT_NEAR(output[idx], 1.0, 1e-4);
+    }
+    decimator_destroy(decimator);
+  }
+  free(memory);
+}
+
+TEST(decimator_tests, decimator_stream_test) {
+  float *memory = (float*)malloc(sizeof(float) * 4096 * 3);
+  if (memory) {
+    float *input = memory;
+    float *expected = &memory[4096];
+    float *output = &memory[4096 * 2];
+    for (unsigned int idx = 0; idx < 4096; idx++) {
+      input[idx] = (float)sin(idx * 0.01) + (float)sin(idx * 1.3);
+    }
+    decimator_t *decimator = decimator_create(4);
+    ASSERT_FALSE(decimator == NULL);
+    unsigned int consumed;
+    unsigned int n_expected = decimator_process(decimator, input, 4096,
+      &consumed, expected, 4096);
+    decimator_destroy(decimator);
+    /* Decimating in small uneven blocks gives the same result. */
+    decimator = decimator_create(4);
+    ASSERT_FALSE(decimator == NULL);
+    unsigned int offset = 0;
+    unsigned int produced = 0;
+    while (offset < 4096) {
+      unsigned int len = 4096 - offset < 37 ? 4096 - offset : 37;
+      produced += decimator_process(decimator, &input[offset], len,
+        &consumed, &output[produced], 5);
+      offset += consumed;
+    }
+    produced += decimator_process(decimator, input, 0, &consumed,
+      &output[produced], 4096);
+    ASSERT_EQ(produced, n_expected);
+    for (unsigned int idx = 0; idx < produced; idx++) {
+      ASSERT_EQ(output[idx], expected[idx]);
+    }
+    decimator_destroy(decimator);
+  }
+  free(memory);
+}
+
+/**
+ * Decimate a 48Khz tone to 8Khz and measure its peak amplitude once the
+ * filter has settled.
+ */
+static float decimate_tone(double frequency) {
+  float *memory = (float*)malloc(sizeof(float) * 4096 * 2);
+  float peak = -1;
+  if (memory) {
+    float *input = memory;
+    float *output = &memory[4096];
+    for (unsigned int idx = 0; idx < 4096; idx++) {
+      input[idx] = (float)sin(2 * M_PI * idx * frequency / 48000);
+    }
+    decimator_t *decimator = decimator_create(6);
+    if (decimator != NULL) {
+      unsigned int consumed;
+      unsigned int produced = decimator_process(decimator, input, 4096,
+        &consumed, output, 4096);
+      peak = 0;
+      for (unsigned int idx = decimator_taps_len(6) / 6; idx < produced;
+           idx++) {
+        peak = fmax(peak, fabs(output[idx]));
+      }
+      decimator_destroy(decimator);
+    }
+  }
+  free(memory);
+  return peak;
+}
+
+TEST(decimator_tests, decimator_alias_test) {
+  /* A tone well above the new Nyquist frequency. */
+  ASSERT_LT(decimate_tone(14400), 1e-3);
+  /* A tone just above the new Nyquist frequency, which would fold back
+     onto 3.5Khz. */
+  ASSERT_LT(decimate_tone(4500), 1e-3);
+  /* A tone in the pass band goes through. */
+  ASSERT_GT(decimate_tone(3000), 0.95);
+}
@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file fingerprint_tests.cpp
+ *  @brief Tests the fingerprint interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../src/fingerprint.h"
+
+/* The number of frames per test track. */
+#define TRACK_FRAMES 500
+
+/* Generate a spectrogram with a sparse, track specific set of peaks over a
+   quiet noise floor. */
+static void generate_spectrogram(unsigned int seed, float *spectrogram) {
+  for (unsigned int idx = 0; idx < TRACK_FRAMES * 65; idx++) {
+    seed = seed * 1103515245 + 12345;
+    spectrogram[idx] = (float)((seed >> 16) % 500) / 100;
+    if ((seed >> 8) % 64 == 0) {
+      spectrogram[idx] += 20 + (float)((seed >> 20) % 40);
+    }
+  }
+}
+
+TEST(fingerprint_tests, fingerprint_extract_test) {
+  float *spectrogram = (float*)calloc(100 * 65, sizeof(float));
+  if (spectrogram) {
+    spectrogram[10 * 65 + 20] = 50.0;
+    spectrogram[30 * 65 + 25] = 40.0;
+    fingerprint_landmark_t landmarks[4];
+    ASSERT_EQ(fingerprint_extract(spectrogram, 100, landmarks, 4), 1u);
+    ASSERT_EQ(landmarks[0].hash,
+      (20u << 12) | ((5u + FINGERPRINT_MAX_DF) << 6) | 20u);
+    ASSERT_EQ(landmarks[0].offset, 10u);
+    /* Peaks which are too far apart are not paired. */
+    spectrogram[30 * 65 + 25] = 0.0;
+    spectrogram[90 * 65 + 25] = 40.0;
+    ASSERT_EQ(fingerprint_extract(spectrogram, 100, landmarks, 4), 0u);
+  }
+  free(spectrogram);
+}
+
+TEST(fingerprint_tests, fingerprint_query_test) {
+  float *spectrogram = (float*)malloc(sizeof(float) * TRACK_FRAMES * 65);
+  if (spectrogram) {
+    fingerprint_index_t *index = fingerprint_index_create();
+    ASSERT_FALSE(index == NULL);
+    for (uint32_t track = 0; track < 8; track++) {
+      generate_spectrogram(track + 1, spectrogram);
+      ASSERT_GT(fingerprint_index_add(index, track, spectrogram,
+        TRACK_FRAMES), 0);
+      /* Build the index in two rounds to exercise merging. */
+      if (track == 3) {
+        ASSERT_TRUE(fingerprint_index_build(index));
+      }
+    }
+    ASSERT_TRUE(fingerprint_index_build(index));
+    ASSERT_GT(fingerprint_index_len(index), 0u);
+    /* Query with an excerpt of the third track. */
+    generate_spectrogram(3, spectrogram);
+    fingerprint_match_t match;
+    ASSERT_TRUE(fingerprint_index_query(index, &spectrogram[120 * 65], 200,
+      &match));
+    ASSERT_EQ(match.track, 2u);
+    ASSERT_EQ(match.offset, 120);
+    ASSERT_GT(match.votes, 10u);
+    /* The index is used in place once saved and loaded. */
+    char path[] = "/tmp/fingerprint_tests_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    ASSERT_TRUE(fingerprint_index_save(index, path));
+    fingerprint_index_t *loaded = fingerprint_index_load(path);
+    ASSERT_FALSE(loaded == NULL);
+    ASSERT_EQ(fingerprint_index_len(loaded), fingerprint_index_len(index));
+    /* Other users can load the index. */
+    struct stat st;
+    ASSERT_EQ(stat(path, &st), 0);
+    ASSERT_EQ(st.st_mode & 0777, 0644u);
+    fingerprint_match_t loaded_match;
+    ASSERT_TRUE(fingerprint_index_query(loaded, &spectrogram[120 * 65], 200,
+      &loaded_match));
+    ASSERT_EQ(loaded_match.track, match.track);
+    ASSERT_EQ(loaded_match.offset, match.offset);
+    ASSERT_EQ(loaded_match.votes, match.votes);
+    /* Saving over the file of a loaded index leaves the index intact. */
+    ASSERT_TRUE(fingerprint_index_save(loaded, path));
+    ASSERT_TRUE(fingerprint_index_query(loaded, &spectrogram[120 * 65], 200,
+      &loaded_match));
+    ASSERT_EQ(loaded_match.votes, match.votes);
+    fingerprint_index_t *reloaded = fingerprint_index_load(path);
+    ASSERT_FALSE(reloaded == NULL);
+    ASSERT_EQ(fingerprint_index_len(reloaded), fingerprint_index_len(index));
+    fingerprint_index_destroy(reloaded);
+    /* Loaded indexes are read-only. */
+    ASSERT_EQ(fingerprint_index_add(loaded, 8, spectrogram, TRACK_FRAMES),
+      -1);
+    fingerprint_index_destroy(loaded);
+    remove(path);
+    ASSERT_TRUE(fingerprint_index_load(path) == NULL);
+    fingerprint_index_destroy(index);
+  }
+  free(spectrogram);
+}
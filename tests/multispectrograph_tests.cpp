@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file multispectrograph_tests.cpp
+ *  @brief Tests the multi-resolution spectrograph interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "../src/multispectrograph.h"
+
+/* Generate a 1Khz sine wave sampled @ 8Khz. */
+#define SINE_WAVE_GEN(N) ((short)(16384 * sin((2 * M_PI * N * 1000) / 8000)))
+
+/* The number of input samples, more than the input buffer holds and
+   ending in the middle of the last 2048 sample frame. */
+#define SIGNAL_LEN 40320
+
+typedef struct recorder {
+  short        *signal;
+  unsigned int  n_samples[3];
+  unsigned int  n_frames[3];
+  uint64_t      last_timestamp;
+  bool          failed;
+} recorder_t;
+
+static void record(void *context, unsigned int resolution,
+                   uint64_t timestamp, float *spectrum) {
+  recorder_t *recorder = (recorder_t*)context;
+  unsigned int n_samples = recorder->n_samples[resolution];
+  /* Fragments come in timestamp order, centered on the same grid. */
+  if (timestamp < recorder->last_timestamp ||
+      timestamp != 1024 + recorder->n_frames[resolution] * n_samples / 2) {
+    recorder->failed = true;
+  }
+  recorder->last_timestamp = timestamp;
+  /* Each fragment matches a standalone spectrograph of the same frame. */
+  float *frame = (float*)malloc(sizeof(float) * n_samples);
+  float *expected = (float*)malloc(sizeof(float) * (n_samples / 2 + 1));
+  spectrograph_t *spectrograph = spectrograph_create_size(n_samples);
+  for (unsigned int idx = 0; idx < n_samples; idx++) {
+    frame[idx] = recorder->signal[timestamp - n_samples / 2 + idx];
+  }
+  spectrograph_transform(spectrograph, frame, expected);
+  for (unsigned int idx = 0; idx < n_samples / 2 + 1; idx++) {
+    if (fabs(spectrum[idx] - expected[idx]) > 1e-3) {
+      recorder->failed = true;
+    }
+  }
+  spectrograph_destroy(spectrograph);
+  free(expected);
+  free(frame);
+  recorder->n_frames[resolution]++;
+}
+
+TEST(multispectrograph_tests, multispectrograph_create_test) {
+  unsigned int n_samples[] = { 128, 100 };
+  unsigned int hops[] = { 64, 64 };
+  ASSERT_TRUE(multispectrograph_create(0, n_samples, hops) == NULL);
+  ASSERT_TRUE(multispectrograph_create(2, n_samples, hops) == NULL);
+  hops[0] = 0;
+  ASSERT_TRUE(multispectrograph_create(1, n_samples, hops) == NULL);
+}
+
+TEST(multispectrograph_tests, multispectrograph_push_test) {
+  short *signal = (short*)malloc(sizeof(short) * SIGNAL_LEN);
+  if (signal) {
+    for (unsigned int idx = 0; idx < SIGNAL_LEN; idx++) {
+      signal[idx] = SINE_WAVE_GEN(idx);
+    }
+    recorder_t recorder;
+    memset(&recorder, 0, sizeof(recorder));
+    recorder.signal = signal;
+    recorder.n_samples[0] = 128;
+    recorder.n_samples[1] = 512;
+    recorder.n_samples[2] = 2048;
+    unsigned int hops[] = { 64, 256, 1024 };
+    multispectrograph_t *msg = multispectrograph_create(3,
+      recorder.n_samples, hops);
+    ASSERT_FALSE(msg == NULL);
+    ASSERT_EQ(spectrograph_n_samples(multispectrograph_resolution(msg, 2)),
+      2048u);
+    /* Feed the signal in small blocks which do not line up with any
+       frame. */
+    int n_frames = 0;
+    for (unsigned int offset = 0; offset < SIGNAL_LEN; offset += 160) {
+      int n = multispectrograph_push(msg, &signal[offset], 160, record,
+        &recorder);
+      ASSERT_GE(n, 0);
+      n_frames += n;
+    }
+    /* The frames after the first incomplete 2048 sample frame are held
+       back until the end of the signal. */
+    unsigned int held = 1024 + recorder.n_frames[2] * 1024;
+    unsigned int held_frames[] = { recorder.n_frames[0],
+      recorder.n_frames[1] };
+    int n = multispectrograph_flush(msg, record, &recorder);
+    multispectrograph_destroy(msg);
+    ASSERT_GE(n, 0);
+    n_frames += n;
+    ASSERT_FALSE(recorder.failed);
+    ASSERT_EQ(held_frames[0], (held - 1024) / 64 + 1);
+    ASSERT_EQ(held_frames[1], (held - 1024) / 256 + 1);
+    ASSERT_LT(held_frames[0], recorder.n_frames[0]);
+    /* Every frame which fits in the signal was generated. */
+    ASSERT_EQ(recorder.n_frames[0], (SIGNAL_LEN - 1024u - 64) / 64 + 1);
+    ASSERT_EQ(recorder.n_frames[1], (SIGNAL_LEN - 1024u - 256) / 256 + 1);
+    ASSERT_EQ(recorder.n_frames[2], (SIGNAL_LEN - 2048u) / 1024 + 1);
+    ASSERT_EQ((unsigned int)n_frames, recorder.n_frames[0] +
+      recorder.n_frames[1] + recorder.n_frames[2]);
+  }
+  free(signal);
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file plan_tests.cpp
+ *  @brief Tests the plan interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "../src/plan.h"
+
+TEST(plan_tests, plan_acquire_test) {
+  ASSERT_TRUE(plan_acquire(PLAN_MIN_SAMPLES / 2, PLAN_WINDOW_HANN) == NULL);
+  ASSERT_TRUE(plan_acquire(PLAN_MAX_SAMPLES * 2, PLAN_WINDOW_HANN) == NULL);
+  ASSERT_TRUE(plan_acquire(384, PLAN_WINDOW_HANN) == NULL);
+  plan_t *a = plan_acquire(256, PLAN_WINDOW_HANN);
+  plan_t *b = plan_acquire(256, PLAN_WINDOW_HANN);
+  ASSERT_FALSE(a == NULL);
+  /* Instances of the same size share one plan. */
+  ASSERT_EQ(a, b);
+  ASSERT_EQ(a->refs, 2u);
+  for (unsigned int idx = 0; idx < 256; idx++) {
+    ASSERT_FLOAT_EQ(a->window[idx],
+      0.5 * (1 - cos((2 * M_PI * idx) / (256 - 1))));
+    ASSERT_FLOAT_EQ(a->power_spec_coeff[idx], 1.0 / 256);
+  }
+  plan_release(a);
+  plan_release(b);
+  plan_cache_clear();
+}
+
+TEST(plan_tests, plan_cache_clear_test) {
+  plan_t *a = plan_acquire(512, PLAN_WINDOW_HANN);
+  ASSERT_FALSE(a == NULL);
+  /* Plans which are in use stay cached. */
+  plan_cache_clear();
+  plan_t *b = plan_acquire(512, PLAN_WINDOW_HANN);
+  ASSERT_EQ(a, b);
+  ASSERT_EQ(b->refs, 2u);
+  plan_release(a);
+  plan_release(b);
+  plan_cache_clear();
+}
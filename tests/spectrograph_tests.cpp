@@ -28,6 +28,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #include "../src/spectrograph.h"
 
@@ -71,4 +72,300 @@ TEST(spectrograph_tests, spectrograph_sine_wave_test) {
     spectrograph_destroy(spectrograph);
   }
   free(memory);
-}
\ No newline at end of file
+}
+
+TEST(spectrograph_tests, spectrograph_size_test) {
+  ASSERT_TRUE(spectrograph_create_size(100) == NULL);
+  float *memory = (float*)aligned_alloc(32, sizeof(float) * 2048 * 2);
+  if (memory) {
+    float *sine_wave_buffer = memory;
+    float *output_buffer = &memory[2048];
+    for (unsigned int idx = 0; idx < 2048; idx++) {
+      sine_wave_buffer[idx] = (float)SINE_WAVE_GEN(idx);
+    }
+    spectrograph_t *spectrograph = spectrograph_create_size(2048);
+    ASSERT_FALSE(spectrograph == NULL);
+    ASSERT_EQ(spectrograph_n_samples(spectrograph), 2048u);
+    spectrograph_set_cache_policy(spectrograph, SPECTROGRAPH_CACHE_THROUGHPUT);
+    ASSERT_TRUE(spectrograph_transform(spectrograph, sine_wave_buffer,
+      output_buffer));
+    /* The 1Khz tone lands in bin 1000 / (8000 / 2048). */
+    unsigned int peak = 0;
+    for (unsigned int idx = 1; idx < 1024 + 1; idx++) {
+      if (output_buffer[idx] > output_buffer[peak]) {
+        peak = idx;
+      }
+    }
+    ASSERT_EQ(peak, 256u);
+    /* The power of the tone grows with the number of samples per frame. */
+    ASSERT_NEAR(output_buffer[peak], SINE_WAVE_SPECTRUM[16] +
+      10 * log10(2048.0 / 128), 0.5);
+    spectrograph_destroy(spectrograph);
+  }
+  free(memory);
+}
+
+TEST(spectrograph_tests, spectrograph_complex_output_test) {
+  float *memory = (float*)malloc(sizeof(float) * (128 + 2 * (64 + 1)));
+  if (memory) {
+    float *sine_wave_buffer = memory;
+    float *output_buffer = &memory[128];
+    for (unsigned int idx = 0; idx < 128; idx++) {
+      sine_wave_buffer[idx] = (float)SINE_WAVE_GEN(idx);
+    }
+    spectrograph_t *spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    spectrograph_set_output_mode(spectrograph, SPECTROGRAPH_OUTPUT_COMPLEX);
+    ASSERT_TRUE(spectrograph_transform(spectrograph, sine_wave_buffer,
+      output_buffer));
+    /* The magnitudes peak at the 1Khz bin. */
+    unsigned int peak = 0;
+    float peak_power = 0;
+    for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+      float power = output_buffer[idx * 2] * output_buffer[idx * 2] +
+        output_buffer[idx * 2 + 1] * output_buffer[idx * 2 + 1];
+      if (power > peak_power) {
+        peak = idx;
+        peak_power = power;
+      }
+    }
+    ASSERT_EQ(peak, 16u);
+    /* The spectrum of a real frame is real at DC. */
+    ASSERT_NEAR(output_buffer[1], 0, 1e-2);
+    /* Gated frames are silent. */
+    spectrograph_set_gate(spectrograph, 1e12);
+    ASSERT_TRUE(spectrograph_transform(spectrograph, sine_wave_buffer,
+      output_buffer));
+    for (unsigned int idx = 0; idx < 2 * (64 + 1); idx++) {
+      ASSERT_EQ(output_buffer[idx], 0);
+    }
+    spectrograph_destroy(spectrograph);
+  }
+  free(memory);
+}
+
+TEST(spectrograph_tests, spectrograph_throughput_policy_test) {
+  float *memory = (float*)aligned_alloc(32, sizeof(float) * 128 * 2);
+  if (memory) {
+    float *sine_wave_buffer = memory;
+    float *output_buffer = &memory[128];
+    for (unsigned int idx = 0; idx < 128; idx++) {
+      sine_wave_buffer[idx] = (float)SINE_WAVE_GEN(idx);
+    }
+    spectrograph_t *spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    spectrograph_set_cache_policy(spectrograph, SPECTROGRAPH_CACHE_THROUGHPUT);
+    ASSERT_TRUE(spectrograph_transform(spectrograph, sine_wave_buffer,
+      output_buffer));
+    for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+      ASSERT_FALSE(fabs(output_buffer[idx] - SINE_WAVE_SPECTRUM[idx]) > 0.05);
+    }
+    /* Unaligned outputs stream their aligned body only. */
+    for (unsigned int offset = 1; offset < 8; offset++) {
+      ASSERT_TRUE(spectrograph_transform(spectrograph, sine_wave_buffer,
+        &output_buffer[offset]));
+      for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+        ASSERT_FALSE(
+          fabs(output_buffer[idx + offset] - SINE_WAVE_SPECTRUM[idx]) > 0.05);
+      }
+    }
+    spectrograph_destroy(spectrograph);
+  }
+  free(memory);
+}
+
+TEST(spectrograph_tests, spectrograph_decimated_sine_wave_test) {
+  /* One second of a 1Khz sine wave sampled @ 48Khz. */
+  float *memory = (float*)malloc(sizeof(float) * (48000 + 64 * 65));
+  if (memory) {
+    float *sine_wave_buffer = memory;
+    float *output_buffer = &memory[48000];
+    for (unsigned int idx = 0; idx < 48000; idx++) {
+      sine_wave_buffer[idx] =
+        (float)(16384 * sin((2 * M_PI * idx * 1000) / 48000));
+    }
+    spectrograph_t *spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    decimator_t *decimator = decimator_create(6);
+    ASSERT_FALSE(decimator == NULL);
+    /* Feed the signal in blocks which do not line up with the frames. */
+    int n_frames = 0;
+    for (unsigned int offset = 0; offset < 48000; offset += 6000) {
+      int n = spectrograph_transform_decimated(spectrograph, decimator,
+        &sine_wave_buffer[offset], 6000, &output_buffer[n_frames * 65],
+        NULL);
+      ASSERT_GE(n, 0);
+      n_frames += n;
+    }
+    ASSERT_EQ(n_frames, 8000 / 128);
+    /* Once the filter has settled the tone lands in the 1Khz bin. */
+    for (int frame = 1; frame < n_frames; frame++) {
+      float *spectrum = &output_buffer[frame * 65];
+      unsigned int peak = 0;
+      for (unsigned int idx = 1; idx < 64 + 1; idx++) {
+        if (spectrum[idx] > spectrum[peak]) {
+          peak = idx;
+        }
+      }
+      ASSERT_EQ(peak, 16u);
+      ASSERT_FALSE(fabs(spectrum[peak] - SINE_WAVE_SPECTRUM[peak]) > 0.5);
+    }
+    decimator_destroy(decimator);
+    spectrograph_destroy(spectrograph);
+  }
+  free(memory);
+}
+
+TEST(spectrograph_tests, spectrograph_decimated_gate_test) {
+  /* Half a second of silence then half a second of a 1Khz sine wave
+     sampled @ 48Khz. */
+  float *memory = (float*)malloc(sizeof(float) * (48000 + 64 * 65));
+  bool *gated = (bool*)malloc(sizeof(bool) * 64);
+  if (memory && gated) {
+    float *input_buffer = memory;
+    float *output_buffer = &memory[48000];
+    for (unsigned int idx = 0; idx < 48000; idx++) {
+      input_buffer[idx] = idx < 24000 ?
+        0 : (float)(16384 * sin((2 * M_PI * idx * 1000) / 48000));
+    }
+    spectrograph_t *spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    decimator_t *decimator = decimator_create(6);
+    ASSERT_FALSE(decimator == NULL);
+    spectrograph_set_gate(spectrograph, 4.0);
+    int n_frames = 0;
+    for (unsigned int offset = 0; offset < 48000; offset += 6000) {
+      int n = spectrograph_transform_decimated(spectrograph, decimator,
+        &input_buffer[offset], 6000, &output_buffer[n_frames * 65],
+        &gated[n_frames]);
+      ASSERT_GE(n, 0);
+      n_frames += n;
+    }
+    ASSERT_EQ(n_frames, 8000 / 128);
+    /* Every fragment is flagged, not only the last one of each call. The
+       silence ends in the middle of frame 31. */
+    for (int frame = 0; frame < n_frames; frame++) {
+      if (frame != 31) {
+        ASSERT_EQ(gated[frame], frame < 31);
+      }
+    }
+    spectrograph_stats_t stats;
+    spectrograph_get_stats(spectrograph, &stats);
+    ASSERT_GE(stats.gated_frames, 31ul);
+    decimator_destroy(decimator);
+    spectrograph_destroy(spectrograph);
+  }
+  free(gated);
+  free(memory);
+}
+
+TEST(spectrograph_tests, spectrograph_gate_test) {
+  float *memory = (float*)malloc(sizeof(float) * 128 * 3);
+  if (memory) {
+    float *silence_buffer = memory;
+    float *sine_wave_buffer = &memory[128];
+    float *output_buffer = &memory[128 * 2];
+    for (unsigned int idx = 0; idx < 128; idx++) {
+      silence_buffer[idx] = (float)(idx % 2 ? 1 : -1);
+      sine_wave_buffer[idx] = (float)SINE_WAVE_GEN(idx);
+    }
+    spectrograph_t *spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    spectrograph_set_gate(spectrograph, 4.0);
+    /* Quiet frames are given the floor of the log power spectrum. */
+    ASSERT_TRUE(spectrograph_transform(spectrograph, silence_buffer,
+      output_buffer));
+    ASSERT_TRUE(spectrograph_gated(spectrograph));
+    for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+      ASSERT_FLOAT_EQ(output_buffer[idx], -300.0);
+    }
+    /* Loud frames are transformed. */
+    ASSERT_TRUE(spectrograph_transform(spectrograph, sine_wave_buffer,
+      output_buffer));
+    ASSERT_FALSE(spectrograph_gated(spectrograph));
+    for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+      ASSERT_FALSE(fabs(output_buffer[idx] - SINE_WAVE_SPECTRUM[idx]) > 0.05);
+    }
+    /* Quiet frames are given the noise profile when there is one. */
+    spectrograph_set_noise_profile(spectrograph, SINE_WAVE_SPECTRUM);
+    ASSERT_TRUE(spectrograph_transform(spectrograph, silence_buffer,
+      output_buffer));
+    ASSERT_TRUE(spectrograph_gated(spectrograph));
+    for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+      ASSERT_EQ(output_buffer[idx], SINE_WAVE_SPECTRUM[idx]);
+    }
+    spectrograph_stats_t stats;
+    spectrograph_get_stats(spectrograph, &stats);
+    ASSERT_EQ(stats.frames, 3ul);
+    ASSERT_EQ(stats.gated_frames, 2ul);
+    spectrograph_reset_stats(spectrograph);
+    spectrograph_get_stats(spectrograph, &stats);
+    ASSERT_EQ(stats.frames, 0ul);
+    ASSERT_EQ(stats.gated_frames, 0ul);
+    spectrograph_destroy(spectrograph);
+  }
+  free(memory);
+}
+
+TEST(spectrograph_tests, spectrograph_normalization_test) {
+  float *memory = (float*)malloc(sizeof(float) * 128 * 5);
+  if (memory) {
+    float *input_buffer = memory;
+    float *output_buffer = &memory[128];
+    float *log_spectrum = &memory[128 * 2];
+    float *mean = &memory[128 * 3];
+    float *var = &memory[128 * 4];
+    spectrograph_t *reference = spectrograph_create();
+    ASSERT_FALSE(reference == NULL);
+    spectrograph_t *spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    spectrograph_set_normalization(spectrograph, SPECTROGRAPH_NORM_RUNNING,
+      0.9);
+    /* Compare against the running statistics computed one bin at a time. */
+    for (unsigned int frame = 0; frame < 8; frame++) {
+      for (unsigned int idx = 0; idx < 128; idx++) {
+        input_buffer[idx] = (float)((frame + 1) * SINE_WAVE_GEN(idx + frame));
+      }
+      ASSERT_TRUE(spectrograph_transform(reference, input_buffer,
+        log_spectrum));
+      ASSERT_TRUE(spectrograph_transform(spectrograph, input_buffer,
+        output_buffer));
+      for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+        if (frame == 0) {
+          mean[idx] = log_spectrum[idx];
+          var[idx] = 1.0;
+        }
+        float diff = log_spectrum[idx] - mean[idx];
+        mean[idx] += 0.1f * diff;
+        var[idx] = 0.9f * (var[idx] + 0.1f * diff * diff);
+        float expected = (log_spectrum[idx] - mean[idx]) /
+          sqrtf(var[idx] + 1e-6f);
+        ASSERT_NEAR(output_buffer[idx], expected, 1e-3);
+      }
+    }
+    /* Frozen statistics survive a round trip through a file. */
+    char path[] = "/tmp/spectrograph_tests_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    ASSERT_TRUE(spectrograph_save_normalization(spectrograph, path));
+    spectrograph_destroy(spectrograph);
+    spectrograph = spectrograph_create();
+    ASSERT_FALSE(spectrograph == NULL);
+    ASSERT_TRUE(spectrograph_load_normalization(spectrograph, path));
+    remove(path);
+    ASSERT_FALSE(spectrograph_load_normalization(spectrograph, path));
+    for (unsigned int frame = 0; frame < 2; frame++) {
+      ASSERT_TRUE(spectrograph_transform(spectrograph, input_buffer,
+        output_buffer));
+      for (unsigned int idx = 0; idx < 64 + 1; idx++) {
+        float expected = (log_spectrum[idx] - mean[idx]) /
+          sqrtf(var[idx] + 1e-6f);
+        ASSERT_NEAR(output_buffer[idx], expected, 1e-3);
+      }
+    }
+    spectrograph_destroy(spectrograph);
+    spectrograph_destroy(reference);
+  }
+  free(memory);
+}
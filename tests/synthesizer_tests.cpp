@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/** @file synthesizer_tests.cpp
+ *  @brief Tests the synthesizer interface.
+ *
+ *  @author Thomas Quintana (quintana.thomas@gmail.com)
+ *  @bug No known bugs.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "../src/spectrograph.h"
+#include "../src/synthesizer.h"
+
+/* Generate a 1Khz sine wave sampled @ 8Khz. */
+#define SINE_WAVE_GEN(N) ((short)(16384 * sin((2 * M_PI * N * 1000) / 8000)))
+
+/* The number of samples per frame. */
+#define FRAME_LEN 512
+
+/* The number of samples between the frames. */
+#define HOP_LEN 128
+
+/* The number of frames analyzed. */
+#define N_FRAMES 32
+
+/* The number of samples of the signal. */
+#define SIGNAL_LEN ((N_FRAMES - 1) * HOP_LEN + FRAME_LEN)
+
+/**
+ * Analyze a signal and resynthesize it with the same gain for every bin.
+ */
+static void round_trip(float *signal, float *output, float gain) {
+  float *spectrum = (float*)malloc(sizeof(float) *
+    spectrograph_complex_output_len(FRAME_LEN));
+  float *gains = (float*)malloc(sizeof(float) *
+    spectrograph_output_len(FRAME_LEN));
+  spectrograph_t *spectrograph = spectrograph_create_size(FRAME_LEN);
+  synthesizer_t *synthesizer = synthesizer_create(FRAME_LEN, HOP_LEN);
+  ASSERT_FALSE(spectrograph == NULL);
+  ASSERT_FALSE(synthesizer == NULL);
+  spectrograph_set_output_mode(spectrograph, SPECTROGRAPH_OUTPUT_COMPLEX);
+  for (int idx = 0; idx < spectrograph_output_len(FRAME_LEN); idx++) {
+    gains[idx] = gain;
+  }
+  for (unsigned int idx = 0; idx < N_FRAMES; idx++) {
+    ASSERT_TRUE(spectrograph_transform(spectrograph, &signal[idx * HOP_LEN],
+      spectrum));
+    ASSERT_TRUE(synthesizer_process(synthesizer, spectrum, gains,
+      &output[idx * HOP_LEN]));
+  }
+  synthesizer_flush(synthesizer, &output[N_FRAMES * HOP_LEN]);
+  synthesizer_destroy(synthesizer);
+  spectrograph_destroy(spectrograph);
+  free(gains);
+  free(spectrum);
+}
+
+TEST(synthesizer_tests, synthesizer_create_test) {
+  ASSERT_TRUE(synthesizer_create(100, 50) == NULL);
+  ASSERT_TRUE(synthesizer_create(FRAME_LEN, 0) == NULL);
+  ASSERT_TRUE(synthesizer_create(FRAME_LEN, FRAME_LEN + 1) == NULL);
+}
+
+TEST(synthesizer_tests, synthesizer_round_trip_test) {
+  float *memory = (float*)malloc(sizeof(float) * SIGNAL_LEN * 2);
+  if (memory) {
+    float *signal = memory;
+    float *output = &memory[SIGNAL_LEN];
+    for (unsigned int idx = 0; idx < SIGNAL_LEN; idx++) {
+      signal[idx] = (float)SINE_WAVE_GEN(idx) + (float)(idx % 7) * 100;
+    }
+    round_trip(signal, output, 1);
+    /* Every sample overlapped by more than one frame is reconstructed. */
+    for (unsigned int idx = HOP_LEN; idx < SIGNAL_LEN - HOP_LEN; idx++) {
+      ASSERT_NEAR(output[idx], signal[idx], 1);
+    }
+    /* The gains scale the signal. */
+    round_trip(signal, output, 0.5);
+    for (unsigned int idx = HOP_LEN; idx < SIGNAL_LEN - HOP_LEN; idx++) {
+      ASSERT_NEAR(output[idx], signal[idx] * 0.5, 1);
+    }
+  }
+  free(memory);
+}
@@ -24,6 +24,7 @@
  *  @bug No known bugs.
  */
 
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <gtest/gtest.h>
@@ -52,6 +53,32 @@ TEST(vector_tests, vector_add_64) {
   free(memory);
 }
 
+TEST(vector_tests, vector_cmvn_64) {
+  /* Allocate properly aligned memory for the test vectors. */
+  float *memory = (float*)aligned_alloc(32, sizeof(float) * 64 * 4);
+  if (memory) {
+    float *a = memory;
+    float *b = &memory[64];
+    float *mean = &memory[128];
+    float *var = &memory[192];
+    /* Initialize the memory. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      a[idx] = 3.0;
+      mean[idx] = 1.0;
+      var[idx] = 2.0;
+    }
+    /* Update the statistics and normalize vector a. */
+    vec_cmvn_64(a, b, mean, var, 0.5);
+    /* Check the results. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      ASSERT_FLOAT_EQ(mean[idx], 2.0);
+      ASSERT_FLOAT_EQ(var[idx], 2.0);
+      ASSERT_FLOAT_EQ(b[idx], 1.0 / sqrt(2.0 + VEC_CMVN_EPSILON));
+    }
+  }
+  free(memory);
+}
+
 TEST(vector_tests, vector_copy_16) {
   /* Allocate properly aligned memory for the test vectors. */
   float *memory = (float*)aligned_alloc(32, sizeof(float) * 64 * 2);
@@ -75,6 +102,26 @@ TEST(vector_tests, vector_copy_16) {
   free(memory);
 }
 
+TEST(vector_tests, vector_dot) {
+  /* Allocate properly aligned memory for the test vectors. */
+  float *memory = (float*)aligned_alloc(32, sizeof(float) * 64 * 2);
+  if (memory) {
+    float *a = memory;
+    float *b = &memory[64];
+    /* Initialize the memory. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      a[idx] = (double)idx;
+      b[idx] = 2.0;
+    }
+    /* Compute the dot products. */
+    ASSERT_EQ(vec_dot(a, b, 64), 4032.0);
+    ASSERT_EQ(vec_dot(a, b, 16), 240.0);
+    /* The first term does not have to be aligned. */
+    ASSERT_EQ(vec_dot(&a[1], b, 16), 272.0);
+  }
+  free(memory);
+}
+
 TEST(vector_tests, vector_multiply_64) {
   /* Allocate properly aligned memory for the test vectors. */
   float *memory = (float*)aligned_alloc(32, sizeof(float) * 64 * 3);
@@ -97,6 +144,30 @@ TEST(vector_tests, vector_multiply_64) {
   free(memory);
 }
 
+TEST(vector_tests, vector_normalize_64) {
+  /* Allocate properly aligned memory for the test vectors. */
+  float *memory = (float*)aligned_alloc(32, sizeof(float) * 64 * 5);
+  if (memory) {
+    float *a = memory;
+    float *b = &memory[64];
+    float *mean = &memory[128];
+    float *scale = &memory[192];
+    /* Initialize the memory. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      a[idx] = 5.0;
+      mean[idx] = 1.0;
+      scale[idx] = 0.5;
+    }
+    /* Normalize vector a into an unaligned destination. */
+    vec_normalize_64(a, &b[1], mean, scale);
+    /* Check the results. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      ASSERT_EQ(b[idx + 1], 2.0);
+    }
+  }
+  free(memory);
+}
+
 TEST(vector_tests, vector_sqrt_64) {
   /* Allocate properly aligned memory for the test vector. */
   float *memory = (float*)aligned_alloc(32, sizeof(float) * 64 * 2);
@@ -136,3 +207,23 @@ TEST(vector_tests, vector_square_64) {
   }
   free(memory);
 }
+
+TEST(vector_tests, vector_stream) {
+  /* Allocate properly aligned memory for the test vectors. */
+  float *memory = (float*)aligned_alloc(32, sizeof(float) * 72 * 2);
+  if (memory) {
+    float *a = &memory[1];
+    float *b = &memory[72];
+    /* Initialize the memory. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      a[idx] = (double)idx;
+    }
+    /* Stream vector a from an unaligned source. */
+    vec_stream(a, b, 64);
+    /* Check the results. */
+    for (unsigned int idx = 0; idx < 64; idx++) {
+      ASSERT_EQ(b[idx], a[idx]);
+    }
+  }
+  free(memory);
+}